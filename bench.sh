@@ -0,0 +1,45 @@
+#!/bin/sh
+# Scaling benchmark: runs the simulation headless with a fixed seed and time step for
+# every backend and a sweep of body counts, and prints one CSV row per run.
+# Usage: bench.sh [EXECUTABLE]
+# Environment:
+# 	SIZES      body counts to try (default 128 to 65536, doubling)
+# 	STEPS      steps per run, including warm-up (default 200)
+# 	BUDGET_MS  frame budget to report the largest fitting N for (default 16.6)
+# 	MAX_MS     stop a backend's sweep once its median step is slower than this (default 1000)
+
+exe=${1:-build-linux/main}
+sizes=${SIZES:-"128 256 512 1024 2048 4096 8192 16384 32768 65536"}
+steps=${STEPS:-200}
+budget_ms=${BUDGET_MS:-16.6}
+max_ms=${MAX_MS:-1000}
+
+if [ ! -x "$exe" ]; then
+	echo "No executable at $exe: run make linux first" >&2
+	exit 1
+fi
+
+echo "backend,n,steps,steps_per_s,pair_interactions_per_s,p50_ms,p99_ms,fold_factor,pair_block"
+
+for backend in $("$exe" --list-backends); do
+	largest=none
+	for n in $sizes; do
+		row=$("$exe" --headless --bench --seed 1 --fixed-dt 16 --backend "$backend" --planets "$n" --frames "$steps" | grep "^$backend,")
+		if [ -z "$row" ]; then
+			echo "$backend: no result for N=$n (out of memory or over texture limits), ending sweep" >&2
+			break
+		fi
+		echo "$row"
+
+		p50=$(echo "$row" | cut -d, -f6)
+		p99=$(echo "$row" | cut -d, -f7)
+		if awk "BEGIN { exit !($p99 <= $budget_ms) }"; then
+			largest=$n
+		fi
+		if awk "BEGIN { exit !($p50 > $max_ms) }"; then
+			echo "$backend: median step over $max_ms ms at N=$n, ending sweep" >&2
+			break
+		fi
+	done
+	echo "$backend: largest N with p99 step within $budget_ms ms: $largest" >&2
+done
@@ -0,0 +1,59 @@
+#!/bin/sh
+# Physics check: steps two planets of unequal mass once, headless, and checks that the
+# momentum each gains is equal and opposite, for gravity alone and for contact alone.
+# Prints one line per case and exits nonzero if any fails.
+# Usage: check.sh [EXECUTABLE]
+# Environment:
+# 	TOLERANCE  largest net momentum change allowed, relative to either planet's (default
+# 	           0.01, as mediump arithmetic may run at half precision)
+
+exe=${1:-build-linux/main}
+tolerance=${TOLERANCE:-0.01}
+
+if [ ! -x "$exe" ]; then
+	echo "No executable at $exe: run make linux first" >&2
+	exit 1
+fi
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# Runs one case. Arguments: name, separation along x, then options for the executable.
+# The planets start at rest, with masses 1 and 4 and radii 1.
+check_case() {
+	name=$1
+	separation=$2
+	shift 2
+	cat > "$dir/$name.txt" <<-EOF
+		planetarium-snapshot 1
+		step 0
+		planets 2
+		0 0 0 0 1 1 1 1 1
+		$separation 0 0 0 1 1 1 4 1
+	EOF
+	if ! "$exe" --headless --no-autotune --initial-state "$dir/$name.txt" --batch 1 --snapshot-every 1 --snapshot-prefix "$dir/$name" "$@" > /dev/null 2>&1; then
+		echo "$name: FAIL (the run failed)"
+		return 1
+	fi
+
+	# Velocities are in columns 3 and 4 and mass in column 8, from line 4 on
+	awk -v name="$name" -v tolerance="$tolerance" '
+		function abs(x) { return x < 0 ? -x : x }
+		NR >= 4 { px[NR - 3] = $8 * $3; py[NR - 3] = $8 * $4 }
+		END {
+			scale = abs(px[1]) + abs(py[1])
+			if (abs(px[2]) + abs(py[2]) > scale) {
+				scale = abs(px[2]) + abs(py[2])
+			}
+			net = abs(px[1] + px[2]) + abs(py[1] + py[2])
+			ok = scale > 0 && net <= tolerance * scale
+			printf "%s: %s (momentum %g and %g, net %g)\n", name, ok ? "ok" : "FAIL", px[1], px[2], net
+			exit !ok
+		}
+	' "$dir/$name-00000001.txt"
+}
+
+status=0
+check_case gravity 0.3 --no-contacts || status=1
+check_case contact 0.03 --no-gravity || status=1
+exit $status
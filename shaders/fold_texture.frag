@@ -1,17 +1,24 @@
 #version 300 es
 
+#ifndef FOLD_FACTOR
+#define FOLD_FACTOR 4
+#endif
+
 uniform sampler2D inputs;
+uniform int input_columns; // Columns holding sums; past them is stale or off the texture
 
 out mediump vec4 out_sum;
 
 void main()
 {
-	// Hard-code fold factor of 4 to avoid a loop
-	ivec2 sum_base = ivec2(int(gl_FragCoord.x) * 4, int(gl_FragCoord.y));
-	mediump vec4 a = texelFetch(inputs, sum_base + ivec2(0, 0), 0);
-	mediump vec4 b = texelFetch(inputs, sum_base + ivec2(1, 0), 0);
-	mediump vec4 c = texelFetch(inputs, sum_base + ivec2(2, 0), 0);
-	mediump vec4 d = texelFetch(inputs, sum_base + ivec2(3, 0), 0);
+	// Constant trip count, so the loop unrolls
+	ivec2 sum_base = ivec2(int(gl_FragCoord.x) * FOLD_FACTOR, int(gl_FragCoord.y));
+	mediump vec4 sum = texelFetch(inputs, sum_base, 0);
+	for (int i = 1; i < FOLD_FACTOR; ++i) {
+		if (sum_base.x + i < input_columns) {
+			sum += texelFetch(inputs, sum_base + ivec2(i, 0), 0);
+		}
+	}
 
-	out_sum = a + b + c + d;
+	out_sum = sum;
 }
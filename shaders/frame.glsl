@@ -0,0 +1,29 @@
+// The per-frame uniform block, laid out as FrameUniforms in main.c. This file goes
+// ahead of every shader (see shader_source_with_defines()), and a shader declares
+// the block by writing FRAME_BLOCK(p); with p the precision of its float members, so
+// fragment shaders can keep them mediump. Members:
+// 	camera
+// 	time_step: seconds since last frame
+// 	planet_r: radius of each planet relative to screen
+// 	gravitational_constant
+// 	spring_k: intersection displacement multiplier
+// 	spring_b: intersection velocity multiplier
+// 	time_scale
+// 	damping: prevents the system from accumulating energy
+// 	interpolation: how far from the previous step to the latest to draw, 0 to 1
+// 	interpolated_bodies: planets in both steps; any later are drawn where they are
+// Comments can't go inside the macro, since each line continues onto the next.
+#define FRAME_BLOCK(p) \
+layout(std140) uniform Frame \
+{ \
+	p vec2 camera; \
+	p float time_step; \
+	p float planet_r; \
+	p float gravitational_constant; \
+	p float spring_k; \
+	p float spring_b; \
+	p float time_scale; \
+	p float damping; \
+	p float interpolation; \
+	highp int interpolated_bodies; \
+}
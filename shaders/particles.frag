@@ -1,10 +1,28 @@
 #version 300 es
 
+// Set to shade a quad as a disc of radius 1 about frag_offset's origin
+#ifndef SDF_DISC
+#define SDF_DISC 0
+#endif
+
 in mediump vec4 frag_color;
+#if SDF_DISC
+in mediump vec2 frag_offset;
+#endif
 
 out mediump vec4 out_color;
 
 void main()
 {
+#if SDF_DISC
+	// Signed distance to the edge; fwidth() turns it into about a pixel of coverage
+	mediump float dist = length(frag_offset) - 1.0;
+	mediump float coverage = clamp(0.5 - dist / fwidth(dist), 0.0, 1.0);
+	if (coverage <= 0.0) {
+		discard;
+	}
+	out_color = vec4(frag_color.rgb, frag_color.a * coverage);
+#else
 	out_color = frag_color;
+#endif
 }
@@ -1,17 +1,27 @@
 #version 300 es
 
 in vec2 vert_displacement;
-in vec4 color;
+in int body; // Which planet this instance draws
 
 uniform sampler2D positions;
-uniform float planet_r; // Radius of each planet relative to screen
-uniform vec2 camera;
+uniform sampler2D previous_positions; // The step before, to interpolate from
+uniform highp usampler2D attributes; // Body records written by create_planet()
+
+FRAME_BLOCK(highp);
 
 out vec4 frag_color;
 
 void main()
 {
-	vec2 current_pos = texelFetch(positions, ivec2(gl_InstanceID, 0), 0).xy;
-	gl_Position = vec4(current_pos + planet_r * vert_displacement - camera, 0.0, 1.0);
-	frag_color = color;
+	// RGBA8 colour, then mass and radius (in units of planet_r) as halves
+	uvec2 record = texelFetch(attributes, ivec2(body, 0), 0).xy;
+	float radius = unpackHalf2x16(record.y).y;
+
+	vec2 current_pos = texelFetch(positions, ivec2(body, 0), 0).xy;
+	if (body < interpolated_bodies) {
+		vec2 previous_pos = texelFetch(previous_positions, ivec2(body, 0), 0).xy;
+		current_pos = mix(previous_pos, current_pos, interpolation);
+	}
+	gl_Position = vec4(current_pos + planet_r * radius * vert_displacement - camera, 0.0, 1.0);
+	frag_color = vec4((uvec4(record.x) >> uvec4(0u, 8u, 16u, 24u)) & 0xFFu) / 255.0;
 }
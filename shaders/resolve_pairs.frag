@@ -0,0 +1,96 @@
+#version 300 es
+
+// Either interaction can be compiled out by defining it as 0 before this point
+#ifndef ENABLE_GRAVITY
+#define ENABLE_GRAVITY 1
+#endif
+#ifndef ENABLE_CONTACTS
+#define ENABLE_CONTACTS 1
+#endif
+// Partners summed by each fragment, so the texture the fold reads back is that many
+// times narrower
+#ifndef PAIR_BLOCK
+#define PAIR_BLOCK 1
+#endif
+
+uniform sampler2D positions;
+uniform highp usampler2D attributes; // Body records written by create_planet()
+uniform int first_body; // Planet of the top row, when the matrix is drawn in strips
+uniform int num_bodies; // Planets in the simulation; texels past them are empty
+
+FRAME_BLOCK(mediump);
+
+// Summed at full precision, as the two passes this replaces were by blending
+out highp vec2 out_impulse;
+
+#if ENABLE_CONTACTS
+mediump vec2 contact_impulse(mediump vec2 separation, mediump vec2 relative_v, mediump float contact_distance)
+{
+	if (length(separation) == 0.0) {
+		return vec2(1.0, 0.0);
+	} else if (length(separation) < contact_distance) {
+		mediump vec2 spring_v = -normalize(separation) * dot(relative_v, normalize(separation));
+		mediump vec2 spring_x = normalize(separation) * (contact_distance - length(separation));
+		return -spring_b * spring_v - spring_k * spring_x;
+	} else {
+		return vec2(0.0, 0.0);
+	}
+}
+#endif
+
+#if ENABLE_GRAVITY
+mediump vec2 attraction(mediump vec2 separation, mediump float softening)
+{
+	mediump float divisor = max(length(separation), softening);
+	return separation * gravitational_constant / (divisor * divisor * divisor);
+}
+#endif
+
+// Impulse on planet you from planet me
+highp vec2 pair_impulse(int me, int you, mediump vec4 your_pv, mediump vec2 your_body)
+{
+	mediump vec4 my_pv = texelFetch(positions, ivec2(me, 0), 0);
+
+	// Mass and radius (in units of planet_r) from the body records
+	mediump vec2 my_body = unpackHalf2x16(texelFetch(attributes, ivec2(me, 0), 0).y);
+	mediump float contact_distance = (my_body.y + your_body.y) * planet_r;
+
+	mediump vec2 separation = (my_pv - your_pv).xy;
+	highp vec2 impulse = vec2(0.0, 0.0);
+
+#if ENABLE_CONTACTS
+	if (me != you) {
+		// A force, so heavier planets are pushed less
+		impulse += contact_impulse(separation, (my_pv - your_pv).zw, contact_distance) / your_body.x;
+	}
+#endif
+#if ENABLE_GRAVITY
+	// Pulled harder by heavier planets
+	impulse += attraction(separation, 0.5 * contact_distance) * my_body.x;
+#endif
+
+	return impulse;
+}
+
+void main()
+{
+	ivec2 discrete_coords = ivec2(gl_FragCoord) + ivec2(0, first_body);
+	int you = discrete_coords.y;
+	mediump vec4 your_pv = texelFetch(positions, ivec2(you, 0), 0);
+	mediump vec2 your_body = unpackHalf2x16(texelFetch(attributes, ivec2(you, 0), 0).y);
+
+#if PAIR_BLOCK == 1
+	highp vec2 impulse = pair_impulse(discrete_coords.x, you, your_pv, your_body);
+#else
+	// Constant trip count, so the loop unrolls; --pair-block keeps it to 32 at most
+	int first_partner = discrete_coords.x * PAIR_BLOCK;
+	highp vec2 impulse = vec2(0.0, 0.0);
+	for (int i = 0; i < PAIR_BLOCK; ++i) {
+		if (first_partner + i < num_bodies) {
+			impulse += pair_impulse(first_partner + i, you, your_pv, your_body);
+		}
+	}
+#endif
+
+	out_impulse = impulse;
+}
@@ -0,0 +1,22 @@
+#version 300 es
+
+// Turns the density texture from splat.frag into planet colour over the background.
+// Alpha approaches 1 as planets pile up, so dense clusters saturate instead of
+// clipping, and their colour is the mean of the planets in them.
+
+uniform sampler2D splats;
+uniform mediump vec2 screen_size;
+
+// How quickly alpha saturates with the number of planets in a texel
+const mediump float EXPOSURE = 2.0;
+
+out mediump vec4 out_color;
+
+void main()
+{
+	mediump vec4 splat = texture(splats, gl_FragCoord.xy / screen_size);
+	if (splat.a <= 0.0) {
+		discard;
+	}
+	out_color = vec4(splat.rgb / splat.a, 1.0 - exp(-splat.a * EXPOSURE));
+}
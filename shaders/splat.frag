@@ -0,0 +1,12 @@
+#version 300 es
+
+// Blended additively: rgb sums colour, a counts planets
+
+in mediump vec4 frag_color;
+
+out mediump vec4 out_splat;
+
+void main()
+{
+	out_splat = vec4(frag_color.rgb, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 300 es
+
+// One point per planet, for glDrawArraysInstanced(GL_POINTS, 0, 1, n) into the
+// low-resolution density texture read by resolve_splats.frag.
+
+in int body; // Which planet this instance draws
+
+uniform sampler2D positions;
+uniform sampler2D previous_positions; // The step before, to interpolate from
+uniform highp usampler2D attributes; // Body records written by create_planet()
+uniform float point_size; // Diameter of a planet of radius 1 in density texels
+
+FRAME_BLOCK(highp);
+
+out vec4 frag_color;
+
+void main()
+{
+	// RGBA8 colour, then mass and radius (in units of planet_r) as halves
+	uvec2 record = texelFetch(attributes, ivec2(body, 0), 0).xy;
+	float radius = unpackHalf2x16(record.y).y;
+
+	vec2 current_pos = texelFetch(positions, ivec2(body, 0), 0).xy;
+	if (body < interpolated_bodies) {
+		vec2 previous_pos = texelFetch(previous_positions, ivec2(body, 0), 0).xy;
+		current_pos = mix(previous_pos, current_pos, interpolation);
+	}
+	gl_Position = vec4(current_pos - camera, 0.0, 1.0);
+	gl_PointSize = max(1.0, point_size * radius);
+	frag_color = vec4((uvec4(record.x) >> uvec4(0u, 8u, 16u, 24u)) & 0xFFu) / 255.0;
+}
@@ -0,0 +1,36 @@
+#version 300 es
+
+// One quad per planet, for glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, n). The
+// disc itself is cut out in particles.frag with SDF_DISC set.
+
+in int body; // Which planet this instance draws
+
+uniform sampler2D positions;
+uniform sampler2D previous_positions; // The step before, to interpolate from
+uniform highp usampler2D attributes; // Body records written by create_planet()
+
+FRAME_BLOCK(highp);
+
+// Room outside the disc for its anti-aliased edge, as a fraction of the radius
+const float EDGE_MARGIN = 0.25;
+
+out vec4 frag_color;
+out vec2 frag_offset;
+
+void main()
+{
+	// RGBA8 colour, then mass and radius (in units of planet_r) as halves
+	uvec2 record = texelFetch(attributes, ivec2(body, 0), 0).xy;
+	float radius = unpackHalf2x16(record.y).y;
+
+	vec2 corner = vec2(float(gl_VertexID % 2), float(gl_VertexID / 2)) * 2.0 - 1.0;
+	frag_offset = corner * (1.0 + EDGE_MARGIN);
+
+	vec2 current_pos = texelFetch(positions, ivec2(body, 0), 0).xy;
+	if (body < interpolated_bodies) {
+		vec2 previous_pos = texelFetch(previous_positions, ivec2(body, 0), 0).xy;
+		current_pos = mix(previous_pos, current_pos, interpolation);
+	}
+	gl_Position = vec4(current_pos + planet_r * radius * frag_offset - camera, 0.0, 1.0);
+	frag_color = vec4((uvec4(record.x) >> uvec4(0u, 8u, 16u, 24u)) & 0xFFu) / 255.0;
+}
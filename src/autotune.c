@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <inttypes.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "options.h"
+#include "program_cache.h"
+#include "autotune.h"
+
+// Picks the fastest way to run the pair passes for each planet count, by timing
+// every candidate the first time a size is seen. Sizes are bucketed by powers of
+// two, so the choice is revisited as the count crosses each one. Results are saved
+// to a file in the per-user data directory named after a hash of the driver, so each
+// machine tunes once per bucket and later runs start with the answer. Bump
+// AUTOTUNE_VERSION when the paths change enough to invalidate old timings.
+//
+// Plain-text format, one bucket per line after the header:
+// 	planetarium-autotune 3
+// 	<planets> <backend> <fold factor> <pair block> <step ms>
+
+#define AUTOTUNE_MAGIC "planetarium-autotune "
+#define AUTOTUNE_VERSION 3
+#define AUTOTUNE_MIN_BUCKET 8 // Below 256 planets every path takes next to no time
+#define AUTOTUNE_MAX_BUCKET 30
+#define AUTOTUNE_RUNS 5 // Timed runs per candidate, after one to warm up
+#define AUTOTUNE_BUDGET_MS 250.0 // Stop timing a candidate after this long
+
+typedef struct AutotuneEntry {
+	SDL_bool known;
+	PairPath path;
+	double step_ms;
+} AutotuneEntry;
+
+static SDL_bool autotune_enabled = SDL_FALSE;
+static char *autotune_file = NULL;
+static AutotuneEntry autotune_entries[AUTOTUNE_MAX_BUCKET + 1];
+
+void free_autotune(void)
+{
+	my_free(autotune_file);
+	autotune_file = NULL;
+	autotune_enabled = SDL_FALSE;
+}
+
+// Reads the choices saved by earlier runs on this machine, if any.
+void load_autotune_file(void)
+{
+	FILE *file = fopen(autotune_file, "r");
+	if (file == NULL) {
+		return;
+	}
+
+	int version = 0;
+	if (fscanf(file, AUTOTUNE_MAGIC "%d", &version) != 1 || version != AUTOTUNE_VERSION) {
+		fclose(file);
+		return;
+	}
+	Uint64 planets;
+	char backend_name[32];
+	int fold_factor;
+	int pair_block;
+	double step_ms;
+	while (fscanf(file, " %" SCNu64 " %31s %d %d %lf", &planets, backend_name, &fold_factor, &pair_block, &step_ms) == 5) {
+		PairPath path = { .fold_factor = fold_factor, .pair_block = pair_block };
+		int bucket = autotune_bucket(planets > INT_MAX ? INT_MAX : (int) planets);
+		if (bucket > 0 && parse_backend(backend_name, &path.backend) && fold_factor >= 2 && pair_block >= 1) {
+			autotune_entries[bucket] = (AutotuneEntry) { SDL_TRUE, path, step_ms };
+		}
+	}
+	fclose(file);
+}
+
+// Writes every known choice back out.
+void save_autotune_file(void)
+{
+	FILE *file = fopen(autotune_file, "w");
+	if (file == NULL) {
+		write_log("Failed to save autotuning results to %s\n", autotune_file);
+		return;
+	}
+	fprintf(file, AUTOTUNE_MAGIC "%d\n", AUTOTUNE_VERSION);
+	for (int bucket = AUTOTUNE_MIN_BUCKET; bucket <= AUTOTUNE_MAX_BUCKET; ++bucket) {
+		const AutotuneEntry *entry = &autotune_entries[bucket];
+		if (entry->known) {
+			fprintf(
+				file,
+				"%" PRIu64 " %s %d %d %.4f\n",
+				(Uint64) 1 << bucket,
+				backend_names[entry->path.backend],
+				entry->path.fold_factor,
+				entry->path.pair_block,
+				entry->step_ms
+			);
+		}
+	}
+	if (fclose(file) != 0) {
+		write_log("Failed to save autotuning results to %s\n", autotune_file);
+	}
+}
+
+// Must be called with a current context. If ignore_saved is set, earlier results are
+// measured again and overwritten.
+// Returns: whether results can be saved; tuning works either way.
+SDL_bool init_autotune(SDL_bool ignore_saved)
+{
+	autotune_enabled = SDL_TRUE;
+	char *dir = SDL_GetPrefPath("Cuttleshock", "planetarium");
+	if (dir == NULL) {
+		return SDL_FALSE;
+	}
+
+	Uint64 driver_hash = 0;
+	const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (int i = 0; i < sizeof(driver_strings) / sizeof(driver_strings[0]); ++i) {
+		const char *str = (const char *) glGetString(driver_strings[i]);
+		hash_string(&driver_hash, str ? str : "");
+	}
+
+	size_t len = strlen(dir) + 64;
+	autotune_file = my_malloc(len);
+	if (autotune_file == NULL) {
+		SDL_free(dir);
+		return SDL_FALSE;
+	}
+	snprintf(autotune_file, len, "%sautotune-%016" PRIx64 ".txt", dir, driver_hash);
+	SDL_free(dir);
+	push_cleanup_fn(free_autotune);
+
+	if (!ignore_saved) {
+		load_autotune_file();
+	}
+	return SDL_TRUE;
+}
+
+// Returns: which size bucket num_planets falls in, or 0 if it's too small to tune.
+int autotune_bucket(int num_planets)
+{
+	if (!autotune_enabled || num_planets < (1 << AUTOTUNE_MIN_BUCKET)) {
+		return 0;
+	}
+	int bucket = AUTOTUNE_MIN_BUCKET;
+	while (bucket < AUTOTUNE_MAX_BUCKET && num_planets >= 1 << (bucket + 1)) {
+		++bucket;
+	}
+	return bucket;
+}
+
+// Returns: whether a choice for the bucket has been made before; if so, path is set.
+SDL_bool autotune_lookup(int bucket, PairPath *path)
+{
+	if (bucket <= 0 || !autotune_entries[bucket].known) {
+		return SDL_FALSE;
+	}
+	*path = autotune_entries[bucket].path;
+	return SDL_TRUE;
+}
+
+// Times the pair passes of every candidate, run by run(), which returns SDL_FALSE if
+// the path can't be used, and saves the fastest for the bucket. Each run is waited
+// on with glFinish() and the quickest counts, as the least disturbed by the rest of
+// the system. The state run() leaves behind is the last candidate's.
+// Returns: whether any candidate ran; if so, best is set.
+SDL_bool autotune_measure(int bucket, const PairPath *candidates, int num_candidates, SDL_bool (*run)(const PairPath *path), PairPath *best)
+{
+	double best_ms = 0.0;
+	int best_index = -1;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	write_log("Autotuning the pair passes for %d+ planets (backend/fold factor/pair block):", 1 << bucket);
+	for (int i = 0; i < num_candidates; ++i) {
+		const PairPath *path = &candidates[i];
+		// The first run builds programs and warms caches
+		if (!run(path)) {
+			continue;
+		}
+		glFinish();
+
+		double min_ms = 0.0;
+		double spent_ms = 0.0;
+		for (int r = 0; r < AUTOTUNE_RUNS && spent_ms < AUTOTUNE_BUDGET_MS; ++r) {
+			Uint64 start = SDL_GetPerformanceCounter();
+			run(path);
+			glFinish();
+			double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+			min_ms = r == 0 ? ms : SDL_min(min_ms, ms);
+			spent_ms += ms;
+		}
+		write_log(
+			"%s %s/%d/%d %.3f ms",
+			best_index < 0 ? "" : ",",
+			backend_names[path->backend],
+			path->fold_factor,
+			path->pair_block,
+			min_ms
+		);
+		if (best_index < 0 || min_ms < best_ms) {
+			best_ms = min_ms;
+			best_index = i;
+		}
+	}
+	if (best_index < 0) {
+		write_log(" nothing ran\n");
+		return SDL_FALSE;
+	}
+
+	*best = candidates[best_index];
+	write_log("; using %s/%d/%d\n", backend_names[best->backend], best->fold_factor, best->pair_block);
+	autotune_entries[bucket] = (AutotuneEntry) { SDL_TRUE, *best, best_ms };
+	if (autotune_file) {
+		save_autotune_file();
+	}
+	return SDL_TRUE;
+}
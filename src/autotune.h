@@ -0,0 +1,16 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+// One way of running the pair passes
+typedef struct PairPath {
+	Backend backend;
+	int fold_factor; // Columns summed per fold pass
+	int pair_block; // Partners summed by each fragment of the pair pass
+} PairPath;
+
+SDL_bool init_autotune(SDL_bool ignore_saved);
+int autotune_bucket(int num_planets);
+SDL_bool autotune_lookup(int bucket, PairPath *path);
+SDL_bool autotune_measure(int bucket, const PairPath *candidates, int num_candidates, SDL_bool (*run)(const PairPath *path), PairPath *best);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "bench.h"
+
+// Steps discarded before measuring, to leave out driver warm-up and shader caching
+#define BENCH_WARMUP_STEPS 10
+
+static Uint64 *bench_samples = NULL; // Step times in performance counter ticks
+static int bench_num_samples = 0;
+static int bench_capacity = 0;
+static int bench_steps_seen = 0;
+
+// Frees the sample buffer.
+void free_bench_samples(void)
+{
+	my_free(bench_samples);
+	bench_samples = NULL;
+	bench_num_samples = 0;
+	bench_capacity = 0;
+}
+
+// Records how long one simulation step took, as measured by SDL_GetPerformanceCounter().
+void bench_add_step(Uint64 counter_ticks)
+{
+	++bench_steps_seen;
+	if (bench_steps_seen <= BENCH_WARMUP_STEPS) {
+		return;
+	}
+
+	if (bench_num_samples >= bench_capacity) {
+		int new_capacity = bench_capacity > 0 ? bench_capacity * 2 : 256;
+		Uint64 *new_samples = my_malloc(new_capacity * sizeof(Uint64));
+		if (new_samples == NULL) {
+			return;
+		}
+		if (bench_samples) {
+			memcpy(new_samples, bench_samples, bench_num_samples * sizeof(Uint64));
+			my_free(bench_samples);
+		} else {
+			push_cleanup_fn(free_bench_samples);
+		}
+		bench_samples = new_samples;
+		bench_capacity = new_capacity;
+	}
+
+	bench_samples[bench_num_samples] = counter_ticks;
+	++bench_num_samples;
+}
+
+int compare_samples(const void *a, const void *b)
+{
+	Uint64 x = *(const Uint64 *) a;
+	Uint64 y = *(const Uint64 *) b;
+	return (x > y) - (x < y);
+}
+
+// Returns: nearest-rank percentile of the sorted samples, in milliseconds.
+double sample_percentile_ms(int percent)
+{
+	int rank = (bench_num_samples * percent + 99) / 100;
+	if (rank < 1) {
+		rank = 1;
+	}
+	return bench_samples[rank - 1] * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Prints one CSV row to stdout, matching the header written by bench.sh:
+// backend,n,steps,steps_per_s,pair_interactions_per_s,p50_ms,p99_ms,fold_factor,pair_block
+void bench_report(const char *backend, int num_planets, int fold_factor, int pair_block)
+{
+	if (bench_num_samples == 0) {
+		write_log("Benchmark finished with no samples: run more than %d frames\n", BENCH_WARMUP_STEPS);
+		return;
+	}
+
+	Uint64 total = 0;
+	for (int i = 0; i < bench_num_samples; ++i) {
+		total += bench_samples[i];
+	}
+	qsort(bench_samples, bench_num_samples, sizeof(Uint64), compare_samples);
+
+	double seconds = (double) total / SDL_GetPerformanceFrequency();
+	double steps_per_s = bench_num_samples / seconds;
+	double pairs_per_step = (double) num_planets * (num_planets - 1);
+
+	printf(
+		"%s,%d,%d,%.2f,%.4g,%.3f,%.3f,%d,%d\n",
+		backend,
+		num_planets,
+		bench_num_samples,
+		steps_per_s,
+		steps_per_s * pairs_per_step,
+		sample_percentile_ms(50),
+		sample_percentile_ms(99),
+		fold_factor,
+		pair_block
+	);
+	fflush(stdout);
+}
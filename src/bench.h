@@ -0,0 +1,7 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+void bench_add_step(Uint64 counter_ticks);
+void bench_report(const char *backend, int num_planets, int fold_factor, int pair_block);
+
+#endif // BENCH_H
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "glad_gl.h"
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "frame_fences.h"
+
+// Bounds how many frames the CPU may submit before the GPU has finished them. Each
+// frame ends with a fence, and the next frame to reuse its slot waits for it before
+// issuing any GL work. One frame in flight gives the least latency, as input is read
+// only once the GPU has caught up; more lets the CPU prepare frames while the GPU is
+// still busy, for throughput. Without this the driver picks, and may queue several.
+
+static GLsync frame_fences[MAX_FRAMES_IN_FLIGHT];
+static int frames_in_flight = 0; // 0 until init_frame_fences()
+static int fence_current = 0;
+static Uint64 fence_stats_interval = 0;
+
+// Time spent in frame_fences_wait(), in performance counter ticks, over the whole
+// run and since the last logged summary
+static Uint64 run_frames = 0;
+static Uint64 run_waits = 0; // Frames that found the GPU still behind
+static Uint64 run_wait_ticks = 0;
+static Uint64 run_max_wait_ticks = 0;
+static Uint64 window_frames = 0;
+static Uint64 window_wait_ticks = 0;
+static Uint64 window_max_wait_ticks = 0;
+
+// Deletes the fences still pending.
+void delete_frame_fences(void)
+{
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+		glDeleteSync(frame_fences[i]);
+		frame_fences[i] = NULL;
+	}
+	frames_in_flight = 0;
+}
+
+// Allows up to max_frames frames, from 1 to MAX_FRAMES_IN_FLIGHT, to be submitted
+// ahead of the GPU. If log_interval is nonzero, wait times are logged after every
+// that many frames.
+void init_frame_fences(int max_frames, Uint64 log_interval)
+{
+	frames_in_flight = max_frames;
+	fence_stats_interval = log_interval;
+	push_cleanup_fn(delete_frame_fences);
+}
+
+// Converts performance counter ticks to milliseconds.
+double ticks_to_ms(Uint64 ticks)
+{
+	return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Call at the start of every frame, before any GL work. Returns once the frame
+// submitted frames_in_flight frames ago has finished on the GPU.
+void frame_fences_wait(void)
+{
+	if (frames_in_flight == 0) {
+		return;
+	}
+
+	GLsync *fence = &frame_fences[fence_current];
+	Uint64 wait_ticks = 0;
+	if (*fence) {
+		Uint64 wait_start = SDL_GetPerformanceCounter();
+		if (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED) != GL_ALREADY_SIGNALED) {
+			++run_waits;
+		}
+		wait_ticks = SDL_GetPerformanceCounter() - wait_start;
+		glDeleteSync(*fence);
+		*fence = NULL;
+	}
+
+	++run_frames;
+	run_wait_ticks += wait_ticks;
+	run_max_wait_ticks = SDL_max(run_max_wait_ticks, wait_ticks);
+	++window_frames;
+	window_wait_ticks += wait_ticks;
+	window_max_wait_ticks = SDL_max(window_max_wait_ticks, wait_ticks);
+	if (fence_stats_interval > 0 && window_frames >= fence_stats_interval) {
+		write_log(
+			"GPU wait %.3f ms mean, %.3f ms max (%d frames in flight)\n",
+			ticks_to_ms(window_wait_ticks) / window_frames,
+			ticks_to_ms(window_max_wait_ticks),
+			frames_in_flight
+		);
+		window_frames = 0;
+		window_wait_ticks = 0;
+		window_max_wait_ticks = 0;
+	}
+}
+
+// Call at the end of every frame, after its last GL work.
+void frame_fences_end_frame(void)
+{
+	if (frames_in_flight == 0) {
+		return;
+	}
+
+	frame_fences[fence_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	fence_current = (fence_current + 1) % frames_in_flight;
+}
+
+// Logs how long frames waited for the GPU over the whole run.
+void log_frame_fence_stats(void)
+{
+	if (run_frames == 0) {
+		return;
+	}
+	write_log(
+		"Waited for the GPU on %" PRIu64 " of %" PRIu64 " frames (%d in flight): mean %.3f ms, max %.3f ms\n",
+		run_waits,
+		run_frames,
+		frames_in_flight,
+		ticks_to_ms(run_wait_ticks) / run_frames,
+		ticks_to_ms(run_max_wait_ticks)
+	);
+}
@@ -0,0 +1,11 @@
+#ifndef FRAME_FENCES_H
+#define FRAME_FENCES_H
+
+#define MAX_FRAMES_IN_FLIGHT 3
+
+void init_frame_fences(int max_frames, Uint64 log_interval);
+void frame_fences_wait(void);
+void frame_fences_end_frame(void);
+void log_frame_fence_stats(void);
+
+#endif // FRAME_FENCES_H
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "frame_pacer.h"
+
+// Holds the native main loop to a target rate using the performance counter, which
+// unlike SDL_GetTicks64() resolves well below a millisecond. Frames are scheduled
+// against fixed deadlines, so lateness in one frame doesn't push back the rest.
+// SDL_Delay() can overshoot by a scheduler tick, so it only covers the wait up to
+// PACER_SPIN_US before the deadline, and the rest is spent polling the counter.
+// Each FramePacer belongs to the one thread whose loop it paces.
+
+#define PACER_SPIN_US 2000
+#define MICROSECONDS 1000000
+
+static Uint64 counter_frequency;
+
+// Starts pacing at target_fps frames per second, or lets frames run back to back if
+// target_fps is 0 (uncapped, or because SDL_GL_SwapWindow() already waits for
+// vsync). If log_interval is nonzero, frame time statistics are logged after every
+// that many frames.
+void init_frame_pacer(FramePacer *pacer, int target_fps, Uint64 log_interval)
+{
+	counter_frequency = SDL_GetPerformanceFrequency();
+	*pacer = (FramePacer) { 0 };
+	pacer->period_ticks = target_fps > 0 ? counter_frequency / target_fps : 0;
+	pacer->stats_interval = log_interval;
+}
+
+// Converts a span of performance counter ticks without overflowing for long spans.
+// Returns: the span in microseconds.
+Uint64 ticks_to_microseconds(Uint64 ticks)
+{
+	return (ticks / counter_frequency) * MICROSECONDS
+		+ (ticks % counter_frequency) * MICROSECONDS / counter_frequency;
+}
+
+// Adds one frame time to the statistics and logs a summary every stats_interval.
+void add_frame_time(FramePacer *pacer, double ms)
+{
+	++pacer->run_frames;
+	double diff = ms - pacer->run_mean;
+	pacer->run_mean += diff / pacer->run_frames;
+	pacer->run_m2 += diff * (ms - pacer->run_mean);
+	pacer->run_max = SDL_max(pacer->run_max, ms);
+
+	++pacer->window_frames;
+	pacer->window_sum += ms;
+	pacer->window_sum_sq += ms * ms;
+	if (pacer->stats_interval > 0 && pacer->window_frames >= pacer->stats_interval) {
+		double mean = pacer->window_sum / pacer->window_frames;
+		double variance = SDL_max(0.0, pacer->window_sum_sq / pacer->window_frames - mean * mean);
+		write_log("%2.2f FPS, frame time %.3f ms, std dev %.3f ms\n", 1000.0 / mean, mean, sqrt(variance));
+		pacer->window_frames = 0;
+		pacer->window_sum = 0.0;
+		pacer->window_sum_sq = 0.0;
+	}
+}
+
+// Call at the start of every frame.
+// Returns: microseconds since the previous call, or one period on the first call.
+Uint64 frame_pacer_begin_frame(FramePacer *pacer)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 elapsed = pacer->period_ticks;
+	if (pacer->frame_start == 0) {
+		pacer->next_deadline = now + pacer->period_ticks;
+	} else {
+		elapsed = now - pacer->frame_start;
+		add_frame_time(pacer, ticks_to_microseconds(elapsed) / 1000.0);
+	}
+	pacer->frame_start = now;
+	return ticks_to_microseconds(elapsed);
+}
+
+// Call at the end of every frame. Returns once the next frame is due: at once if
+// uncapped, or if this frame ran so late that waiting would only add to the delay.
+void frame_pacer_wait(FramePacer *pacer)
+{
+	if (pacer->period_ticks == 0) {
+		return;
+	}
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (now >= pacer->next_deadline + pacer->period_ticks) {
+		// A whole frame behind: start the schedule again rather than rush to catch up
+		pacer->next_deadline = now + pacer->period_ticks;
+		return;
+	}
+
+	Uint64 spin_ticks = counter_frequency * PACER_SPIN_US / MICROSECONDS;
+	if (pacer->next_deadline > now + spin_ticks) {
+		SDL_Delay((Uint32) (ticks_to_microseconds(pacer->next_deadline - now - spin_ticks) / 1000));
+	}
+	while (SDL_GetPerformanceCounter() < pacer->next_deadline) {
+		// Spin: the last stretch is too short to trust to the scheduler
+	}
+	pacer->next_deadline += pacer->period_ticks;
+}
+
+// Call instead of frame_pacer_wait() after a frame that waited on something else,
+// such as events while idle. The next frame starts a new schedule and reports one
+// period, and the wait isn't counted as frame time.
+void frame_pacer_skip(FramePacer *pacer)
+{
+	pacer->frame_start = 0;
+}
+
+// Logs frame time statistics for the whole run; what names the frames, e.g. "frames".
+void log_frame_pacer_stats(FramePacer *pacer, const char *what)
+{
+	if (pacer->run_frames < 2) {
+		return;
+	}
+	write_log(
+		"Over %" PRIu64 " %s: mean %.3f ms, std dev %.3f ms, max %.3f ms\n",
+		pacer->run_frames,
+		what,
+		pacer->run_mean,
+		sqrt(pacer->run_m2 / (pacer->run_frames - 1)),
+		pacer->run_max
+	);
+}
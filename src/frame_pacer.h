@@ -0,0 +1,26 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+typedef struct FramePacer {
+	Uint64 period_ticks; // 0 when uncapped or when swaps wait for vsync
+	Uint64 stats_interval; // Frames between logged summaries, or 0 for none
+	Uint64 frame_start; // Counter value at the start of the current frame
+	Uint64 next_deadline;
+	// Frame times in milliseconds, over the whole run (Welford's method) and since
+	// the last logged summary
+	Uint64 run_frames;
+	double run_mean;
+	double run_m2;
+	double run_max;
+	Uint64 window_frames;
+	double window_sum;
+	double window_sum_sq;
+} FramePacer;
+
+void init_frame_pacer(FramePacer *pacer, int target_fps, Uint64 log_interval);
+Uint64 frame_pacer_begin_frame(FramePacer *pacer);
+void frame_pacer_wait(FramePacer *pacer);
+void frame_pacer_skip(FramePacer *pacer);
+void log_frame_pacer_stats(FramePacer *pacer, const char *what);
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,215 @@
+#include <stdio.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "gpu_timer.h"
+#include "trace.h"
+
+// Per-pass GPU timing with GL_TIMESTAMP queries. Results are read back
+// GPU_TIMER_LATENCY frames after they are issued, and only once the driver reports
+// them available, so timing never makes the CPU wait for the GPU. If the GPU is
+// further behind than that, frames go untimed instead. A pass may run more than once
+// in a frame, e.g. when the simulation catches up by several steps. Each run gets
+// its own queries, and its times are summed; runs beyond GPU_TIMER_RUNS go untimed.
+
+#define GPU_TIMER_LATENCY 4 // Frames of queries in flight
+#define GPU_TIMER_WINDOW 60 // Frames per rolling average, and between log reports
+#define GPU_TIMER_RUNS 8 // Runs of each pass timed per frame; covers MAX_STEPS_PER_FRAME
+
+typedef struct GpuTimerFrame {
+	GLuint queries[NUM_GPU_PASSES][GPU_TIMER_RUNS][2]; // Start and end timestamps
+	int runs[NUM_GPU_PASSES]; // Runs issued, with both timestamps
+	SDL_bool pending; // Queries issued but not yet read back
+	Uint64 trace_frame; // Frame number the queries belong to, for trace_gpu_zone()
+} GpuTimerFrame;
+
+static const char *gpu_pass_names[NUM_GPU_PASSES] = {
+	[GPU_PASS_PAIRS] = "pairs",
+	[GPU_PASS_FOLD] = "fold",
+	[GPU_PASS_MOTION] = "motion",
+	[GPU_PASS_CULL] = "cull",
+	[GPU_PASS_DRAW] = "draw",
+};
+
+static SDL_bool gpu_timers_enabled = SDL_FALSE;
+static SDL_bool gpu_timers_logging = SDL_FALSE;
+static GpuTimerFrame gpu_timer_frames[GPU_TIMER_LATENCY];
+static int gpu_timer_current = 0;
+static SDL_bool gpu_timer_skip = SDL_TRUE; // Is the current frame going untimed?
+
+// Sliding window of pass times in nanoseconds, as with the FPS counter in main()
+static GLuint64 gpu_pass_samples[NUM_GPU_PASSES][GPU_TIMER_WINDOW];
+static SDL_bool gpu_pass_sampled[NUM_GPU_PASSES][GPU_TIMER_WINDOW];
+static int gpu_sample_index = 0;
+static int gpu_frames_collected = 0;
+static int gpu_frames_skipped = 0;
+
+// Deletes the query objects made by init_gpu_timers().
+void delete_gpu_timers(void)
+{
+#ifndef __EMSCRIPTEN__
+	for (int i = 0; i < GPU_TIMER_LATENCY; ++i) {
+		glDeleteQueries(2 * GPU_TIMER_RUNS * NUM_GPU_PASSES, &gpu_timer_frames[i].queries[0][0][0]);
+	}
+#endif
+	gpu_timers_enabled = SDL_FALSE;
+}
+
+// Sets up query objects. Until this succeeds, the other functions do nothing. Results
+// are always passed on to trace_gpu_zone(), and also logged if log_stats is set.
+// Returns: whether GPU timing is available.
+SDL_bool init_gpu_timers(SDL_bool log_stats)
+{
+#ifdef __EMSCRIPTEN__
+	// WebGL only offers timer queries through EXT_disjoint_timer_query_webgl2
+	return SDL_FALSE;
+#else
+	GLint counter_bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+	if (counter_bits == 0) {
+		return SDL_FALSE;
+	}
+
+	for (int i = 0; i < GPU_TIMER_LATENCY; ++i) {
+		glGenQueries(2 * GPU_TIMER_RUNS * NUM_GPU_PASSES, &gpu_timer_frames[i].queries[0][0][0]);
+		gpu_timer_frames[i].pending = SDL_FALSE;
+	}
+	push_cleanup_fn(delete_gpu_timers);
+	gpu_timers_enabled = SDL_TRUE;
+	gpu_timers_logging = log_stats;
+	return SDL_TRUE;
+#endif
+}
+
+// Logs mean and max time per pass over the last GPU_TIMER_WINDOW timed frames.
+void log_gpu_timers(void)
+{
+	write_log("GPU ms (mean/max):");
+	for (int pass = 0; pass < NUM_GPU_PASSES; ++pass) {
+		GLuint64 total = 0;
+		GLuint64 max = 0;
+		int count = 0;
+		for (int i = 0; i < GPU_TIMER_WINDOW; ++i) {
+			if (gpu_pass_sampled[pass][i]) {
+				total += gpu_pass_samples[pass][i];
+				max = SDL_max(max, gpu_pass_samples[pass][i]);
+				++count;
+			}
+		}
+		if (count > 0) {
+			write_log(" %s %.3f/%.3f", gpu_pass_names[pass], total / (count * 1e6), max / 1e6);
+		}
+	}
+	write_log(" (%d frames untimed)\n", gpu_frames_skipped);
+	gpu_frames_skipped = 0;
+}
+
+// Reads back a frame's results if they are all ready, or waits for them if told to.
+// Returns: whether they were read.
+SDL_bool collect_gpu_timer_frame(GpuTimerFrame *frame, SDL_bool wait)
+{
+#ifndef __EMSCRIPTEN__
+	for (int pass = 0; pass < NUM_GPU_PASSES && !wait; ++pass) {
+		if (frame->runs[pass] > 0) {
+			// Queries complete in order, so the last one stands for the rest
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(frame->queries[pass][frame->runs[pass] - 1][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				return SDL_FALSE;
+			}
+		}
+	}
+
+	for (int pass = 0; pass < NUM_GPU_PASSES; ++pass) {
+		gpu_pass_sampled[pass][gpu_sample_index] = frame->runs[pass] > 0;
+		gpu_pass_samples[pass][gpu_sample_index] = 0;
+		for (int run = 0; run < frame->runs[pass]; ++run) {
+			GLuint64 start, end;
+			glGetQueryObjectui64v(frame->queries[pass][run][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(frame->queries[pass][run][1], GL_QUERY_RESULT, &end);
+			gpu_pass_samples[pass][gpu_sample_index] += end > start ? end - start : 0;
+			trace_gpu_zone(gpu_pass_names[pass], frame->trace_frame, start, end);
+		}
+	}
+#endif
+	frame->pending = SDL_FALSE;
+
+	gpu_sample_index = (gpu_sample_index + 1) % GPU_TIMER_WINDOW;
+	++gpu_frames_collected;
+	if (gpu_timers_logging && gpu_frames_collected % GPU_TIMER_WINDOW == 0) {
+		log_gpu_timers();
+	}
+	return SDL_TRUE;
+}
+
+// Call once at the start of every frame, before any gpu_timer_begin().
+void gpu_timer_begin_frame(void)
+{
+	if (!gpu_timers_enabled) {
+		return;
+	}
+
+	gpu_timer_current = (gpu_timer_current + 1) % GPU_TIMER_LATENCY;
+	GpuTimerFrame *frame = &gpu_timer_frames[gpu_timer_current];
+
+	if (frame->pending && !collect_gpu_timer_frame(frame, SDL_FALSE)) {
+		// Reissuing the queries now would discard results still to come
+		gpu_timer_skip = SDL_TRUE;
+		++gpu_frames_skipped;
+		return;
+	}
+
+	gpu_timer_skip = SDL_FALSE;
+	frame->trace_frame = trace_frame_number();
+	for (int pass = 0; pass < NUM_GPU_PASSES; ++pass) {
+		frame->runs[pass] = 0;
+	}
+}
+
+// Marks the start of a pass on the GPU timeline.
+void gpu_timer_begin(GpuPass pass)
+{
+	GpuTimerFrame *frame = &gpu_timer_frames[gpu_timer_current];
+	if (!gpu_timers_enabled || gpu_timer_skip || frame->runs[pass] >= GPU_TIMER_RUNS) {
+		return;
+	}
+#ifndef __EMSCRIPTEN__
+	glQueryCounter(frame->queries[pass][frame->runs[pass]][0], GL_TIMESTAMP);
+#endif
+}
+
+// Marks the end of a pass started with gpu_timer_begin().
+void gpu_timer_end(GpuPass pass)
+{
+	GpuTimerFrame *frame = &gpu_timer_frames[gpu_timer_current];
+	if (!gpu_timers_enabled || gpu_timer_skip || frame->runs[pass] >= GPU_TIMER_RUNS) {
+		return;
+	}
+#ifndef __EMSCRIPTEN__
+	glQueryCounter(frame->queries[pass][frame->runs[pass]][1], GL_TIMESTAMP);
+#endif
+	++frame->runs[pass];
+	frame->pending = SDL_TRUE;
+}
+
+// Waits for and reads back every frame still in flight, oldest first. This stalls, so
+// only call it when the results are needed now, e.g. before write_trace().
+void gpu_timer_flush(void)
+{
+	if (!gpu_timers_enabled) {
+		return;
+	}
+	for (int i = 1; i <= GPU_TIMER_LATENCY; ++i) {
+		GpuTimerFrame *frame = &gpu_timer_frames[(gpu_timer_current + i) % GPU_TIMER_LATENCY];
+		if (frame->pending) {
+			collect_gpu_timer_frame(frame, SDL_TRUE);
+		}
+	}
+}
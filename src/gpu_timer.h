@@ -0,0 +1,20 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+// Each pass timed by gpu_timer_begin() / gpu_timer_end(). Keep in step with gpu_pass_names.
+typedef enum GpuPass {
+	GPU_PASS_PAIRS,
+	GPU_PASS_FOLD,
+	GPU_PASS_MOTION,
+	GPU_PASS_CULL,
+	GPU_PASS_DRAW,
+	NUM_GPU_PASSES,
+} GpuPass;
+
+SDL_bool init_gpu_timers(SDL_bool log_stats);
+void gpu_timer_begin_frame(void);
+void gpu_timer_begin(GpuPass pass);
+void gpu_timer_end(GpuPass pass);
+void gpu_timer_flush(void);
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,167 @@
+#include <stdio.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "headless.h"
+
+// A surfaceless EGL context for machines with no display server. Mesa provides this
+// on any Linux box (llvmpipe if there is no GPU); nothing is ever presented, so
+// rendering has to target a framebuffer object.
+
+static EGLDisplay egl_display = EGL_NO_DISPLAY;
+static EGLContext egl_context = EGL_NO_CONTEXT;
+static EGLConfig egl_config = EGL_NO_CONFIG_KHR;
+static EGLint context_attribs[] = {
+	EGL_CONTEXT_MAJOR_VERSION, 3,
+	EGL_CONTEXT_MINOR_VERSION, 3,
+	EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+	EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+	EGL_NONE,
+};
+
+// For use in assert_or_cleanup() and similar.
+// Returns: EGL_BAD_ALLOC -> "EGL_BAD_ALLOC", etc..
+const char *egl_get_error_stringified(void)
+{
+#define CASE(X) case EGL_##X: return "EGL_" #X;
+	switch (eglGetError()) {
+		CASE(SUCCESS);
+		CASE(NOT_INITIALIZED);
+		CASE(BAD_ACCESS);
+		CASE(BAD_ALLOC);
+		CASE(BAD_ATTRIBUTE);
+		CASE(BAD_CONFIG);
+		CASE(BAD_CONTEXT);
+		CASE(BAD_CURRENT_SURFACE);
+		CASE(BAD_DISPLAY);
+		CASE(BAD_MATCH);
+		CASE(BAD_NATIVE_PIXMAP);
+		CASE(BAD_NATIVE_WINDOW);
+		CASE(BAD_PARAMETER);
+		CASE(BAD_SURFACE);
+		CASE(CONTEXT_LOST);
+		default:
+			return "[not a valid EGL error code]";
+	}
+#undef CASE
+}
+
+// Releases everything acquired by create_headless_context().
+void destroy_headless_context(void)
+{
+	eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (egl_context != EGL_NO_CONTEXT) {
+		eglDestroyContext(egl_display, egl_context);
+		egl_context = EGL_NO_CONTEXT;
+	}
+	eglTerminate(egl_display);
+	egl_display = EGL_NO_DISPLAY;
+}
+
+// Returns: a display that needs no window system, or the default display if the
+// surfaceless platform is unavailable.
+EGLDisplay get_surfaceless_display(void)
+{
+	const char *client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (client_exts && strstr(client_exts, "EGL_MESA_platform_surfaceless")) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (get_platform_display) {
+			return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+// Creates a desktop OpenGL core context of at least the given version, with no
+// surface, and makes it current.
+// Returns: success.
+SDL_bool create_headless_context(int major, int minor)
+{
+	egl_display = get_surfaceless_display();
+	if (egl_display == EGL_NO_DISPLAY) {
+		return SDL_FALSE;
+	}
+
+	EGLint egl_major, egl_minor;
+	if (!eglInitialize(egl_display, &egl_major, &egl_minor)) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(destroy_headless_context);
+	write_log("EGL version %d.%d\n", egl_major, egl_minor);
+
+	const char *display_exts = eglQueryString(egl_display, EGL_EXTENSIONS);
+	if (!display_exts || !strstr(display_exts, "EGL_KHR_surfaceless_context")) {
+		write_log("EGL_KHR_surfaceless_context unavailable\n");
+		return SDL_FALSE;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		return SDL_FALSE;
+	}
+
+	// Surfaceless contexts don't need a config, but not every driver accepts none
+	EGLint num_configs = 0;
+	const EGLint config_attribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE,
+	};
+	if (!eglChooseConfig(egl_display, config_attribs, &egl_config, 1, &num_configs) || num_configs < 1) {
+		egl_config = EGL_NO_CONFIG_KHR;
+	}
+
+	context_attribs[1] = major;
+	context_attribs[3] = minor;
+	egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attribs);
+	if (egl_context == EGL_NO_CONTEXT) {
+		return SDL_FALSE;
+	}
+
+	if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+		return SDL_FALSE;
+	}
+
+	return SDL_TRUE;
+}
+
+// Returns: the context made by create_headless_context().
+void *get_headless_context(void)
+{
+	return egl_context;
+}
+
+// Creates another context like the one from create_headless_context(), sharing its
+// textures, buffers, programs and sync objects, for use on another thread.
+// Returns: the new context, or NULL on failure.
+void *create_shared_headless_context(void)
+{
+	EGLContext context = eglCreateContext(egl_display, egl_config, egl_context, context_attribs);
+	return context == EGL_NO_CONTEXT ? NULL : context;
+}
+
+// Destroys a context from create_shared_headless_context().
+void destroy_shared_headless_context(void *context)
+{
+	eglDestroyContext(egl_display, context);
+}
+
+// Makes context current on the calling thread, or releases the thread's context if
+// context is NULL.
+// Returns: success.
+SDL_bool make_headless_context_current(void *context)
+{
+	if (context == NULL) {
+		return eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+	return eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+// Usage: gladLoadGL((GLADloadfunc) headless_get_proc_address);
+void *headless_get_proc_address(const char *name)
+{
+	return (void *) eglGetProcAddress(name);
+}
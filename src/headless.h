@@ -0,0 +1,12 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+const char *egl_get_error_stringified(void);
+SDL_bool create_headless_context(int major, int minor);
+void *get_headless_context(void);
+void *create_shared_headless_context(void);
+void destroy_shared_headless_context(void *context);
+SDL_bool make_headless_context_current(void *context);
+void *headless_get_proc_address(const char *name);
+
+#endif // HEADLESS_H
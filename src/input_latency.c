@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "input_latency.h"
+
+// Measures how long input takes to reach the screen: from the SDL timestamp of the
+// earliest event a frame acts on to when the GPU finishes that frame, swap included.
+// A frame that acted on input ends with a fence and, where the driver has them, a
+// GL_TIMESTAMP query. Both are checked without blocking at the start of later frames;
+// the query dates the finish exactly, and without one the check itself does, so
+// samples may then run late by up to a frame. Time spent waiting for the display to
+// scan out is not included.
+
+#define LATENCY_PENDING 8 // Frames awaiting the GPU; input in any more goes unmeasured
+#define LATENCY_SAMPLES 4096 // Latest samples kept for the percentiles
+#define LATENCY_RESYNC_FRAMES 600 // How often to re-measure the CPU-GPU clock offset
+
+typedef struct PendingFrame {
+	GLsync done;
+	GLuint query;
+	Uint64 input_counter; // Performance counter value of the earliest input
+} PendingFrame;
+
+static SDL_bool latency_enabled = SDL_FALSE;
+static Uint64 latency_log_interval = 0;
+static SDL_bool have_timestamps = SDL_FALSE;
+static double gpu_offset_ms = 0.0; // CPU milliseconds minus GPU milliseconds
+static Uint64 frames_since_resync = 0;
+
+static Uint64 frame_input_counter = 0; // Earliest input this frame, or 0 for none
+static PendingFrame pending[LATENCY_PENDING];
+static int pending_first = 0;
+static int pending_count = 0;
+static Uint64 frames_unmeasured = 0;
+
+static double samples_ms[LATENCY_SAMPLES];
+static double sorted_ms[LATENCY_SAMPLES]; // Scratch for log_input_latency()
+static Uint64 samples_taken = 0;
+
+// Deletes the fences and queries still pending.
+void delete_input_latency(void)
+{
+	for (int i = 0; i < LATENCY_PENDING; ++i) {
+		glDeleteSync(pending[i].done);
+		pending[i].done = NULL;
+	}
+#ifndef __EMSCRIPTEN__
+	if (have_timestamps) {
+		for (int i = 0; i < LATENCY_PENDING; ++i) {
+			glDeleteQueries(1, &pending[i].query);
+		}
+	}
+#endif
+	latency_enabled = SDL_FALSE;
+}
+
+// Converts performance counter ticks to milliseconds.
+double counter_to_ms(Uint64 counter)
+{
+	return counter * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Pairs the current GPU and CPU clocks, so that GPU timestamps can be compared with
+// input times.
+void sync_latency_clock(void)
+{
+#ifndef __EMSCRIPTEN__
+	GLint64 gpu_now;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+	gpu_offset_ms = counter_to_ms(SDL_GetPerformanceCounter()) - gpu_now / 1e6;
+#endif
+	frames_since_resync = 0;
+}
+
+// Starts measuring. If log_interval is nonzero, percentiles are logged after every
+// that many samples.
+void init_input_latency(Uint64 log_interval)
+{
+#ifndef __EMSCRIPTEN__
+	GLint counter_bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+	have_timestamps = counter_bits > 0;
+	if (have_timestamps) {
+		for (int i = 0; i < LATENCY_PENDING; ++i) {
+			glGenQueries(1, &pending[i].query);
+		}
+		sync_latency_clock();
+	}
+#endif
+	push_cleanup_fn(delete_input_latency);
+	latency_log_interval = log_interval;
+	latency_enabled = SDL_TRUE;
+}
+
+// Notes input that changes what the current frame draws, such as a camera drag.
+// timestamp is the event's SDL timestamp, in milliseconds since SDL_Init();
+// replayed events have none, and are ignored.
+void input_latency_mark(Uint32 timestamp)
+{
+	if (!latency_enabled || timestamp == 0) {
+		return;
+	}
+	// Date it on the performance counter, which the rest of the measurement uses
+	Uint32 age_ms = SDL_GetTicks() - timestamp;
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 age = SDL_min(now, age_ms * SDL_GetPerformanceFrequency() / 1000);
+	if (frame_input_counter == 0 || now - age < frame_input_counter) {
+		frame_input_counter = now - age;
+	}
+}
+
+int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+// Logs percentiles of the latest samples.
+void log_input_latency(void)
+{
+	int count = (int) SDL_min(samples_taken, LATENCY_SAMPLES);
+	if (count == 0) {
+		return;
+	}
+	memcpy(sorted_ms, samples_ms, count * sizeof(sorted_ms[0]));
+	qsort(sorted_ms, count, sizeof(sorted_ms[0]), compare_doubles);
+	write_log(
+		"Input to frame done over %d inputs: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms",
+		count,
+		sorted_ms[count / 2],
+		sorted_ms[count * 9 / 10],
+		sorted_ms[count * 99 / 100],
+		sorted_ms[count - 1]
+	);
+	if (frames_unmeasured > 0) {
+		write_log(" (%" PRIu64 " frames unmeasured)", frames_unmeasured);
+	}
+	write_log("\n");
+}
+
+// Takes samples from every pending frame the GPU has finished, oldest first. Call
+// at the start of every frame.
+void input_latency_poll(void)
+{
+	if (!latency_enabled) {
+		return;
+	}
+	while (pending_count > 0) {
+		PendingFrame *frame = &pending[pending_first];
+		GLenum status = glClientWaitSync(frame->done, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			return;
+		}
+
+		double done_ms = counter_to_ms(SDL_GetPerformanceCounter());
+#ifndef __EMSCRIPTEN__
+		if (have_timestamps) {
+			GLuint64 gpu_done;
+			glGetQueryObjectui64v(frame->query, GL_QUERY_RESULT, &gpu_done);
+			done_ms = SDL_min(done_ms, gpu_done / 1e6 + gpu_offset_ms);
+		}
+#endif
+		glDeleteSync(frame->done);
+		frame->done = NULL;
+		pending_first = (pending_first + 1) % LATENCY_PENDING;
+		--pending_count;
+
+		samples_ms[samples_taken % LATENCY_SAMPLES] = SDL_max(0.0, done_ms - counter_to_ms(frame->input_counter));
+		++samples_taken;
+		if (latency_log_interval > 0 && samples_taken % latency_log_interval == 0) {
+			log_input_latency();
+		}
+	}
+}
+
+// Call once every frame has been submitted, swap included. If it acted on input,
+// starts watching for the GPU to finish it.
+void input_latency_end_frame(void)
+{
+	if (!latency_enabled) {
+		return;
+	}
+	if (have_timestamps && ++frames_since_resync >= LATENCY_RESYNC_FRAMES) {
+		sync_latency_clock();
+	}
+	if (frame_input_counter == 0) {
+		return;
+	}
+	if (pending_count == LATENCY_PENDING) {
+		++frames_unmeasured;
+		frame_input_counter = 0;
+		return;
+	}
+
+	PendingFrame *frame = &pending[(pending_first + pending_count) % LATENCY_PENDING];
+#ifndef __EMSCRIPTEN__
+	if (have_timestamps) {
+		glQueryCounter(frame->query, GL_TIMESTAMP);
+	}
+#endif
+	frame->done = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame->input_counter = frame_input_counter;
+	++pending_count;
+	frame_input_counter = 0;
+	// The fence can only signal once the driver has been handed it
+	glFlush();
+}
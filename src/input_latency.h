@@ -0,0 +1,10 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+void init_input_latency(Uint64 log_interval);
+void input_latency_mark(Uint32 timestamp);
+void input_latency_poll(void);
+void input_latency_end_frame(void);
+void log_input_latency(void);
+
+#endif // INPUT_LATENCY_H
@@ -1,5 +1,6 @@
 #include <time.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -15,18 +16,59 @@
 
 #include "util.h"
 #include "opengl_util.h"
+#include "options.h"
+#include "replay.h"
+#include "bench.h"
+#include "gpu_timer.h"
+#include "trace.h"
+#include "program_cache.h"
+#include "shader_bundle.h"
+#include "frame_pacer.h"
+#include "frame_fences.h"
+#include "state_exchange.h"
+#include "input_latency.h"
+#include "autotune.h"
+#ifndef __EMSCRIPTEN__
+#include "snapshot.h"
+#endif
+#ifdef HAVE_EGL
+#include "headless.h"
+#endif
+#ifdef HAVE_INOTIFY
+#include "shader_watch.h"
+#endif
 
 #define WINDOW_W 640
 #define WINDOW_H 480
-#define FPS_CAP 60
 
-SDL_Window *g_window;
+SDL_Window *g_window = NULL;
 SDL_GLContext g_glcontext;
 
+// Default framebuffer, or an offscreen one when headless
+GLuint g_screen_framebuffer = 0;
+GLuint g_screen_renderbuffer;
+
 GLuint g_draw_vao;
+GLuint g_sprite_vao;
+GLuint g_splat_vao;
 
 GLuint g_circle_vbo;
-GLuint g_colour_vbo;
+GLuint g_body_vbo; // 0, 1, 2, ..., for drawing every planet when not culling
+
+// One RG32UI texel a planet: RGBA8 colour, then half-float mass and radius
+GLuint g_attribute_texture;
+
+// Indices of the planets left after culling, and the indirect draw command that
+// counts them
+SDL_bool g_culling = SDL_FALSE;
+GLuint g_visible_vbo;
+GLuint g_draw_command_buffer;
+GLuint g_cull_group_buffer;
+
+// Density map drawn by RENDERER_SPLAT, at 1 / SPLAT_DOWNSCALE of the screen size
+GLuint g_splat_framebuffer;
+GLuint g_splat_texture;
+Renderer g_last_renderer = NUM_RENDERERS; // To log when draw() switches
 
 GLuint g_motion_framebuffer[2];
 GLuint g_motion_texture[2];
@@ -35,26 +77,180 @@ int g_motion_framebuffer_active = 0;
 GLuint g_impulse_texture[2];
 GLuint g_impulse_framebuffer[2];
 int g_impulse_framebuffer_active = 0;
+// Rows of pairs the impulse textures hold: every planet's, or one strip's at a time
+int g_impulse_rows;
+// Columns they hold: one per planet, or per block when --pair-block fixes the block
+int g_impulse_columns;
+GLuint g_impulse_sum_texture; // Summed strips: one impulse per planet, in a column
+
+// Mirrors the std140 layout of the Frame uniform block declared in the shaders
+typedef struct FrameUniforms {
+	GLfloat camera[2];
+	GLfloat time_step;
+	GLfloat planet_r;
+	GLfloat gravitational_constant;
+	GLfloat spring_k;
+	GLfloat spring_b;
+	GLfloat time_scale;
+	GLfloat damping;
+	GLfloat interpolation;
+	GLint interpolated_bodies;
+	GLfloat padding[1]; // Block size rounds up to a multiple of vec4
+} FrameUniforms;
+
+FrameUniforms g_frame_uniforms;
+GLuint g_frame_ubo;
 
 GLuint g_draw_program;
+GLuint g_sprite_program;
+GLuint g_splat_program;
+GLuint g_resolve_splat_program;
 GLuint g_motion_program;
-GLuint g_intersection_program;
-GLuint g_attraction_program;
+GLuint g_pair_program;
 GLuint g_fold_program;
+GLuint g_cull_program;
+GLint g_cull_num_bodies_uniform;
+GLint g_cull_stage_uniform;
+
+// Uniform locations in g_pair_program and g_fold_program, looked up again whenever
+// they change
+GLuint g_pair_uniforms_program;
+GLint g_pair_first_body_uniform;
+GLint g_pair_num_bodies_uniform;
+GLuint g_fold_uniforms_program;
+GLint g_fold_input_columns_uniform;
+
+// Physics programs specialised by physics_defines(), kept once built so that
+// toggling features back and forth doesn't recompile. Index by [gravity][contacts].
+SDL_bool g_gravity_enabled;
+SDL_bool g_contacts_enabled;
+GLuint g_pair_variants[2][2];
+GLuint g_motion_variants[2][2];
+char g_physics_defines[128];
+char g_pair_defines[160];
+char g_fold_defines[64];
+
+// Pair programs for blocks other than the current one's, parked as they were when the
+// path last switched away (the current block's entry is stale until it's parked again)
+#define MAX_PAIR_BLOCK_VARIANTS 4
+typedef struct PairBlockVariants {
+	int pair_block;
+	GLuint programs[2][2];
+} PairBlockVariants;
+PairBlockVariants g_pair_block_variants[MAX_PAIR_BLOCK_VARIANTS];
+int g_num_pair_block_variants = 0;
+
+// How the pair passes run now, and fold programs by FOLD_FACTOR, built on first use
+#define MAX_FOLD_VARIANTS 8
+typedef struct FoldVariant {
+	int fold_factor;
+	GLuint program;
+} FoldVariant;
+PairPath g_pair_path;
+FoldVariant g_fold_variants[MAX_FOLD_VARIANTS];
+int g_num_fold_variants = 0;
+
+// What the autotuner chooses between, and the planet count bucket it last chose for
+// (blocks leave the fold so little to do that only one fold factor is tried with them)
+const PairPath g_pair_path_candidates[] = {
+	{ BACKEND_FRAGMENT, 2, 1 },
+	{ BACKEND_FRAGMENT, 4, 1 },
+	{ BACKEND_FRAGMENT, 8, 1 },
+	{ BACKEND_FRAGMENT, 16, 1 },
+	{ BACKEND_FRAGMENT, 4, 8 },
+	{ BACKEND_FRAGMENT, 4, 32 },
+	{ BACKEND_TILED, 2, 1 },
+	{ BACKEND_TILED, 4, 1 },
+	{ BACKEND_TILED, 8, 1 },
+	{ BACKEND_TILED, 16, 1 },
+	{ BACKEND_TILED, 4, 8 },
+	{ BACKEND_TILED, 4, 32 },
+};
+#define NUM_PAIR_PATH_CANDIDATES (sizeof(g_pair_path_candidates) / sizeof(g_pair_path_candidates[0]))
+int g_autotune_bucket = -1;
 
 int g_num_planets = 0;
+int g_max_planets; // Capacity of every per-planet buffer and texture
+Uint64 g_frames_run = 0;
+#ifndef __EMSCRIPTEN__
+// Planets to start with, from --initial-state, until finish_startup() uploads them
+Snapshot g_initial_state = { 0 };
+Uint64 g_initial_step = 0; // Steps simulated before the initial state
+#endif
+
+#define BATCH_POLL_STEPS 64 // How often a batch checks for Ctrl-C
+
+// With --sim-rate on the drawing thread, frames bank their time and spend it in
+// steps of g_sim_step_us, drawing the remainder by interpolation; otherwise 0, and
+// each frame runs one step of its own length
+#define MAX_STEPS_PER_FRAME 4
+Uint64 g_sim_step_us = 0;
+Uint64 g_sim_accumulator_us = 0;
+
+// What create_planet() uploads: position and velocity, then the attribute record
+typedef struct Planet {
+	GLfloat motion[4];
+	GLuint record[2];
+} Planet;
+
+// Simulation thread, when the simulation runs apart from drawing. It holds
+// g_sim_lock for each step, so the main thread takes it to touch anything the
+// passes use. Positions reach draw() through state_exchange.c instead.
+SDL_Thread *g_sim_thread = NULL;
+SDL_GLContext g_sim_context = NULL;
+SDL_mutex *g_sim_lock = NULL;
+SDL_atomic_t g_sim_quit;
+GLuint g_sim_vao; // Framebuffers and vertex arrays aren't shared between contexts
+GLuint g_sim_frame_ubo;
+FrameUniforms g_sim_frame_uniforms;
+// Requests for the simulation thread to act on before its next step
+#define MAX_QUEUED_PLANETS 64
+Planet g_queued_planets[MAX_QUEUED_PLANETS];
+int g_num_queued_planets = 0;
+SDL_bool g_physics_requested = SDL_FALSE;
+SDL_bool g_requested_gravity; // The main thread's view of the physics features
+SDL_bool g_requested_contacts;
+SDL_cond *g_sim_wake = NULL; // Signalled under g_sim_lock when an idle thread has work
+SDL_bool g_sim_idle = SDL_FALSE; // The main thread's simulation_idle(), passed on
+int g_sim_pending_steps = 0;
+Uint32 g_sim_published_event = (Uint32) -1; // Pushed to wake an idle main thread
+
+// Idle when paused with P, or hidden unless --no-background-throttle is given: no
+// steps run but those asked for with N, nothing is drawn unless g_redraw_needed,
+// and native builds block on events between frames
+#define IDLE_WAIT_MS 100
+SDL_bool g_paused = SDL_FALSE;
+SDL_bool g_window_hidden = SDL_FALSE;
+int g_pending_steps = 0;
+SDL_bool g_redraw_needed = SDL_TRUE;
 
 SDL_bool g_dragging_camera = SDL_FALSE;
 GLfloat g_camera[2] = { 0.0, 0.0 };
 
-#define MAX_PLANETS 128
+#define DEFAULT_MAX_PLANETS 128
+// Largest whole pair matrix to allocate (both textures) unless --backend fragment
+// insists; beyond it, pairs are evaluated in strips
+#define PAIR_MATRIX_BUDGET_MIB 1024
 #define POINT_RADIUS 0.02
 #define CIRCLE_SIDES 10
 // Used together, so have to be distinct
 #define POSITION_TEX_UNIT_OFFSET 0
 #define ATTRACTION_TEX_UNIT_OFFSET 1
+#define ATTRIBUTE_TEX_UNIT_OFFSET 2
+#define PREVIOUS_POSITION_TEX_UNIT_OFFSET 3
 // Used in a separate shader
 #define FOLD_TEX_UNIT_OFFSET 0
+#define SPLAT_TEX_UNIT_OFFSET 1
+#define SPLAT_DOWNSCALE 4
+#define FRAME_UNIFORM_BINDING 0
+// Match cull_bodies.comp
+#define CULL_GROUP_SIZE 64
+#define VISIBLE_STORAGE_BINDING 0
+#define COMMAND_STORAGE_BINDING 1
+#define GROUP_STORAGE_BINDING 2
+#define CULL_COUNT 0
+#define CULL_SCAN 1
+#define CULL_WRITE 2
 
 void destroy_window(void)
 {
@@ -66,26 +262,56 @@ void delete_glcontext(void)
 	SDL_GL_DeleteContext(g_glcontext);
 }
 
-void create_planet(GLfloat x, GLfloat y, GLfloat dx, GLfloat dy, GLfloat r, GLfloat g, GLfloat b)
+// Appends a planet to the simulation state. Call from whichever thread steps the
+// simulation.
+void upload_planet(const Planet *planet)
 {
-	if (g_num_planets >= MAX_PLANETS) {
+	if (g_num_planets >= g_max_planets) {
 		assert_or_debug(SDL_FALSE, "Attempted to create planet over limit", NULL);
 		return;
 	}
 
-	GLfloat vbo_data[] = {
-		r, g, b, 1.0,
-	};
-	glBindBuffer(GL_ARRAY_BUFFER, g_colour_vbo);
-		glBufferSubData(GL_ARRAY_BUFFER, g_num_planets * sizeof(vbo_data), sizeof(vbo_data), vbo_data);
+	glBindTexture(GL_TEXTURE_2D, g_attribute_texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, g_num_planets, 0, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, planet->record);
 
-	glBindTexture(GL_TEXTURE_2D, g_motion_texture[g_motion_framebuffer_active]);
-		GLfloat position_data[] = { x, y, dx, dy };
-		glTexSubImage2D(GL_TEXTURE_2D, 0, g_num_planets, 0, 1, 1, GL_RGBA, GL_FLOAT, position_data);
+	// In both motion textures, so that it doesn't appear to fly in from wherever the
+	// previous step left its texel
+	for (int i = 0; i < 2; ++i) {
+		glBindTexture(GL_TEXTURE_2D, g_motion_texture[i]);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, g_num_planets, 0, 1, 1, GL_RGBA, GL_FLOAT, planet->motion);
+	}
 
 	++g_num_planets;
 }
 
+// Mass and radius are relative to the defaults: 1 is a planet like any other. With
+// a simulation thread, the planet is queued for it to add before its next step.
+void create_planet(GLfloat x, GLfloat y, GLfloat dx, GLfloat dy, GLfloat r, GLfloat g, GLfloat b, GLfloat mass, GLfloat radius)
+{
+	Planet planet = {
+		.motion = { x, y, dx, dy },
+		.record = {
+			pack_unorm_4x8(r, g, b, 1.0),
+			float_to_half(mass) | (GLuint) float_to_half(radius) << 16,
+		},
+	};
+	if (g_sim_thread == NULL) {
+		upload_planet(&planet);
+		g_redraw_needed = SDL_TRUE;
+		return;
+	}
+
+	SDL_LockMutex(g_sim_lock);
+		if (g_num_planets + g_num_queued_planets >= g_max_planets || g_num_queued_planets >= MAX_QUEUED_PLANETS) {
+			assert_or_debug(SDL_FALSE, "Attempted to create planet over limit", NULL);
+		} else {
+			g_queued_planets[g_num_queued_planets] = planet;
+			++g_num_queued_planets;
+			SDL_CondSignal(g_sim_wake);
+		}
+	SDL_UnlockMutex(g_sim_lock);
+}
+
 void push_quit_event(void)
 {
 	SDL_Event quit_event;
@@ -100,17 +326,481 @@ void create_random_planet(Sint32 x, Sint32 y)
 	GLfloat y_relative = 1.0 - (GLfloat)(y) * 2.0 / WINDOW_H;
 	GLfloat dx = (1.0 - (GLfloat)(x - g_camera[0]) * 2.0 / WINDOW_W) * 0.003;
 	GLfloat dy = ((GLfloat)(y - g_camera[1]) * 2.0 / WINDOW_H - 1.0) * 0.003;
-	GLfloat r = (my_rand() % 256) * (1.0 / 256.0);
-	GLfloat g = (my_rand() % 256) * (1.0 / 256.0);
-	GLfloat b = (my_rand() % 256) * (1.0 / 256.0);
+	GLfloat r = (my_rand() % 256) * (1.0 / 255.0);
+	GLfloat g = (my_rand() % 256) * (1.0 / 255.0);
+	GLfloat b = (my_rand() % 256) * (1.0 / 255.0);
+
+	create_planet(x_relative, y_relative, dx, dy, r, g, b, 1.0, 1.0);
+}
+
+// Runs transform feedback once to fill g_circle_vbo; the program isn't kept.
+void setup_init_circle_program(GLuint program)
+{
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, g_circle_vbo);
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "num_sides"), CIRCLE_SIDES);
+
+		glEnable(GL_RASTERIZER_DISCARD);
+			glBeginTransformFeedback(GL_POINTS);
+				glDrawArrays(GL_POINTS, 0, CIRCLE_SIDES + 2);
+			glEndTransformFeedback();
+		glDisable(GL_RASTERIZER_DISCARD);
+	// WebGL exhibits undefined behaviour if a buffer in use is also bound as TFBO
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+	glDeleteProgram(program);
+}
+
+// Points the bound vertex array's per-instance planet index at the list left by
+// cull_bodies() if culling, or else at every planet in order. Everything else about
+// the planet is looked up by that index.
+void bind_body_attributes(GLuint program)
+{
+	glUniform1i(glGetUniformLocation(program, "attributes"), ATTRIBUTE_TEX_UNIT_OFFSET);
+
+	GLint in_body = glGetAttribLocation(program, "body");
+	glEnableVertexAttribArray(in_body);
+	glVertexAttribDivisor(in_body, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, g_culling ? g_visible_vbo : g_body_vbo);
+		glVertexAttribIPointer(in_body, 1, GL_INT, 0, 0);
+}
+
+void setup_draw_program(GLuint program)
+{
+	glUseProgram(program);
+	glBindVertexArray(g_draw_vao);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "previous_positions"), PREVIOUS_POSITION_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+
+		GLint in_vertex = glGetAttribLocation(program, "vert_displacement");
+		glEnableVertexAttribArray(in_vertex);
+		glBindBuffer(GL_ARRAY_BUFFER, g_circle_vbo);
+			glVertexAttribPointer(in_vertex, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+		bind_body_attributes(program);
+}
+
+void setup_sprite_program(GLuint program)
+{
+	glUseProgram(program);
+	glBindVertexArray(g_sprite_vao);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "previous_positions"), PREVIOUS_POSITION_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+
+		// Corners come from gl_VertexID, so the only attribute is per planet
+		bind_body_attributes(program);
+}
+
+void setup_splat_program(GLuint program)
+{
+	glUseProgram(program);
+	glBindVertexArray(g_splat_vao);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "previous_positions"), PREVIOUS_POSITION_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+
+		// A planet's diameter, 2 * POINT_RADIUS in clip space, measured in density texels
+		GLfloat point_size = SDL_max(1.0, POINT_RADIUS * WINDOW_H / SPLAT_DOWNSCALE);
+		glUniform1f(glGetUniformLocation(program, "point_size"), point_size);
+
+		bind_body_attributes(program);
+}
+
+void setup_resolve_splat_program(GLuint program)
+{
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "splats"), SPLAT_TEX_UNIT_OFFSET);
+		glUniform2f(glGetUniformLocation(program, "screen_size"), WINDOW_W, WINDOW_H);
+}
+
+void setup_cull_program(GLuint program)
+{
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "previous_positions"), PREVIOUS_POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "attributes"), ATTRIBUTE_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+		g_cull_num_bodies_uniform = glGetUniformLocation(program, "num_bodies");
+		g_cull_stage_uniform = glGetUniformLocation(program, "stage");
+}
+
+void setup_motion_program(GLuint program)
+{
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "attractions"), ATTRACTION_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+}
+
+// Used by every specialisation of resolve_pairs.frag
+void setup_pair_program(GLuint program)
+{
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "positions"), POSITION_TEX_UNIT_OFFSET);
+		glUniform1i(glGetUniformLocation(program, "attributes"), ATTRIBUTE_TEX_UNIT_OFFSET);
+		bind_uniform_block(program, "Frame", FRAME_UNIFORM_BINDING);
+	// A new program may reuse a deleted one's name
+	g_pair_uniforms_program = 0;
+}
+
+void setup_fold_program(GLuint program)
+{
+	glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "inputs"), FOLD_TEX_UNIT_OFFSET);
+	// A new program may reuse a deleted one's name
+	g_fold_uniforms_program = 0;
+}
+
+#ifndef __EMSCRIPTEN__
+// Builds the culling pass and its buffers, if the driver can run compute shaders and
+// indirect draws.
+// Returns: whether draw() can cull.
+SDL_bool init_culling(void)
+{
+	if (!GLAD_GL_ARB_compute_shader
+		|| !GLAD_GL_ARB_shader_storage_buffer_object
+		|| !GLAD_GL_ARB_shader_image_load_store
+		|| !GLAD_GL_ARB_draw_indirect
+		|| !GLAD_GL_ARB_ES3_1_compatibility
+	) {
+		return SDL_FALSE;
+	}
+
+	g_cull_program = load_compute_program("cull_bodies.comp", NULL);
+	if (g_cull_program == 0) {
+		return SDL_FALSE;
+	}
+	setup_cull_program(g_cull_program);
+
+	glGenBuffers(1, &g_visible_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, g_visible_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLint) * g_max_planets, NULL, GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &g_draw_command_buffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_draw_command_buffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, 4 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &g_cull_group_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_cull_group_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * ((g_max_planets + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), NULL, GL_DYNAMIC_COPY);
+
+	return SDL_TRUE;
+}
+#endif
+
+// Writes the defines that specialise the pair and motion programs.
+void physics_defines(char *buf, size_t bufsiz, SDL_bool gravity, SDL_bool contacts)
+{
+	snprintf(
+		buf,
+		bufsiz,
+		"#define ENABLE_GRAVITY %d\n#define ENABLE_CONTACTS %d\n#define ENABLE_IMPULSES %d\n",
+		gravity ? 1 : 0,
+		contacts ? 1 : 0,
+		gravity || contacts ? 1 : 0
+	);
+}
+
+// Writes the defines for the pair program, which also sums pair_block partners per
+// fragment.
+void pair_defines(char *buf, size_t bufsiz, SDL_bool gravity, SDL_bool contacts, int pair_block)
+{
+	physics_defines(buf, bufsiz, gravity, contacts);
+	size_t len = strlen(buf);
+	snprintf(buf + len, bufsiz - len, "#define PAIR_BLOCK %d\n", pair_block);
+}
+
+// Switches to the pair and motion programs specialised for this combination of
+// features, building them on first use. Keeps the current ones if that fails.
+void use_physics_variant(SDL_bool gravity, SDL_bool contacts)
+{
+	GLuint *pair_program = &g_pair_variants[gravity][contacts];
+	GLuint *motion_program = &g_motion_variants[gravity][contacts];
+	if (*pair_program == 0 || *motion_program == 0) {
+		char defines[sizeof(g_physics_defines)];
+		char pair_block_defines[sizeof(g_pair_defines)];
+		physics_defines(defines, sizeof(defines), gravity, contacts);
+		pair_defines(pair_block_defines, sizeof(pair_block_defines), gravity, contacts, g_pair_path.pair_block);
+		char *pair_out = "out_impulse";
+		char *motion_out = "out_position";
+		GLuint new_pair_program = load_program("quad.vert", "resolve_pairs.frag", pair_block_defines, 1, &pair_out, 0, NULL);
+		GLuint new_motion_program = load_program("line.vert", "resolve_motion.frag", defines, 1, &motion_out, 0, NULL);
+		if (new_pair_program == 0 || new_motion_program == 0) {
+			write_log("Failed to build physics programs for gravity %d, contacts %d\n", gravity, contacts);
+			glDeleteProgram(new_pair_program);
+			glDeleteProgram(new_motion_program);
+			return;
+		}
+		setup_pair_program(new_pair_program);
+		setup_motion_program(new_motion_program);
+		*pair_program = new_pair_program;
+		*motion_program = new_motion_program;
+	}
+
+	g_gravity_enabled = gravity;
+	g_contacts_enabled = contacts;
+	g_pair_program = *pair_program;
+	g_motion_program = *motion_program;
+	physics_defines(g_physics_defines, sizeof(g_physics_defines), gravity, contacts);
+	pair_defines(g_pair_defines, sizeof(g_pair_defines), gravity, contacts, g_pair_path.pair_block);
+	write_log("Gravity %s, contacts %s\n", gravity ? "on" : "off", contacts ? "on" : "off");
+}
+
+// Toggles physics features from the main thread. With a simulation thread, the
+// switch happens before its next step.
+void request_physics_variant(SDL_bool gravity, SDL_bool contacts)
+{
+	g_requested_gravity = gravity;
+	g_requested_contacts = contacts;
+	if (g_sim_thread == NULL) {
+		use_physics_variant(gravity, contacts);
+		return;
+	}
+
+	SDL_LockMutex(g_sim_lock);
+		g_physics_requested = SDL_TRUE;
+	SDL_UnlockMutex(g_sim_lock);
+}
+
+// Returns: whether the simulation should hold still, because it's paused or hidden.
+SDL_bool simulation_idle(void)
+{
+	return g_paused || (g_window_hidden && g_options.background_throttle);
+}
+
+// Passes a change in simulation_idle() or a single step on to the simulation
+// thread, if there is one, waking it if it's waiting.
+void sync_sim_idle(void)
+{
+	if (g_sim_thread == NULL) {
+		return;
+	}
+	SDL_LockMutex(g_sim_lock);
+		g_sim_idle = simulation_idle();
+		g_sim_pending_steps += g_pending_steps;
+		g_pending_steps = 0;
+		SDL_CondSignal(g_sim_wake);
+	SDL_UnlockMutex(g_sim_lock);
+}
+
+// Stops or restarts stepping, as P does.
+void set_paused(SDL_bool paused)
+{
+	g_paused = paused;
+	write_log(paused ? "Paused\n" : "Resumed\n");
+	sync_sim_idle();
+}
+
+// Pauses if need be, then runs one step.
+void request_single_step(void)
+{
+	if (!g_paused) {
+		set_paused(SDL_TRUE);
+	}
+	++g_pending_steps;
+	sync_sim_idle();
+}
+
+// Length of a step run with N: the step --fixed-dt or --sim-rate sets, or else one
+// frame at the target rate.
+// Returns: microseconds.
+Uint64 single_step_us(void)
+{
+	if (g_options.fixed_delta > 0) {
+		return g_options.fixed_delta * 1000;
+	}
+	if (g_sim_step_us > 0) {
+		return g_sim_step_us;
+	}
+	return 1000000 / (g_options.sim_rate > 0 ? g_options.sim_rate : g_options.target_fps);
+}
+
+// Every program, built together at startup. setup() runs once the program has
+// linked, in this order.
+typedef struct ProgramSpec {
+	GLuint *program; // Where to keep it, or NULL if setup() is its only use
+	char *vert;
+	char *frag;
+	char *defines; // See shader_source_with_defines()
+	char *out; // Fragment output, or NULL
+	const char *transform; // Transform feedback varying, or NULL
+	void (*setup) (GLuint program);
+	GLuint (*variants)[2]; // Other specialisations of the same sources, or NULL
+} ProgramSpec;
+
+const ProgramSpec g_program_specs[] = {
+	{ NULL, "init_circle.vert", "init_circle.frag", NULL, NULL, "position", setup_init_circle_program, NULL },
+	{ &g_draw_program, "particles.vert", "particles.frag", NULL, "out_color", NULL, setup_draw_program, NULL },
+	{ &g_sprite_program, "sprite.vert", "particles.frag", "#define SDF_DISC 1\n", "out_color", NULL, setup_sprite_program, NULL },
+	{ &g_splat_program, "splat.vert", "splat.frag", NULL, "out_splat", NULL, setup_splat_program, NULL },
+	{ &g_resolve_splat_program, "quad.vert", "resolve_splats.frag", NULL, "out_color", NULL, setup_resolve_splat_program, NULL },
+	{ &g_motion_program, "line.vert", "resolve_motion.frag", g_physics_defines, "out_position", NULL, setup_motion_program, g_motion_variants },
+	{ &g_pair_program, "quad.vert", "resolve_pairs.frag", g_pair_defines, "out_impulse", NULL, setup_pair_program, g_pair_variants },
+	{ &g_fold_program, "quad.vert", "fold_texture.frag", g_fold_defines, "out_sum", NULL, setup_fold_program, NULL },
+};
+
+#define NUM_PROGRAMS (sizeof(g_program_specs) / sizeof(g_program_specs[0]))
+
+#ifndef __EMSCRIPTEN__
+// Compute programs, which are optional and so built on their own, e.g. by
+// init_culling(); listed here to be reloaded like the rest.
+typedef struct ComputeProgramSpec {
+	GLuint *program; // Left at 0 when the feature is unavailable
+	char *comp;
+	char *defines;
+	void (*setup) (GLuint program);
+} ComputeProgramSpec;
+
+const ComputeProgramSpec g_compute_program_specs[] = {
+	{ &g_cull_program, "cull_bodies.comp", NULL, setup_cull_program },
+};
+
+#define NUM_COMPUTE_PROGRAMS (sizeof(g_compute_program_specs) / sizeof(g_compute_program_specs[0]))
+#endif
+
+ProgramBuild g_program_builds[NUM_PROGRAMS];
+
+// Submits every compile and link without waiting on any of them.
+void start_program_builds(void)
+{
+	for (int i = 0; i < NUM_PROGRAMS; ++i) {
+		const ProgramSpec *spec = &g_program_specs[i];
+		char *outs[] = { spec->out };
+		const char *transforms[] = { spec->transform };
+		assert_or_cleanup(
+			start_program_build(
+				&g_program_builds[i],
+				spec->vert,
+				spec->frag,
+				spec->defines,
+				spec->out ? 1 : 0,
+				outs,
+				spec->transform ? 1 : 0,
+				transforms
+			),
+			"Failed to read shaders",
+			NULL
+		);
+	}
+}
+
+// Never blocks.
+// Returns: whether every program has finished compiling and linking.
+SDL_bool program_builds_done(void)
+{
+	for (int i = 0; i < NUM_PROGRAMS; ++i) {
+		if (!program_build_done(&g_program_builds[i])) {
+			return SDL_FALSE;
+		}
+	}
+	return SDL_TRUE;
+}
+
+// Shows an empty frame and checks for requests to quit while programs build, so that
+// the window responds from the moment it opens. Events are only peeked at: the rest
+// stay queued for the first frame, which records or replays them like any others.
+// Returns: SDL_FALSE if asked to quit.
+SDL_bool present_loading_frame(void)
+{
+	SDL_PumpEvents();
+	SDL_Event events[16];
+	if (SDL_PeepEvents(events, 1, SDL_PEEKEVENT, SDL_QUIT, SDL_QUIT) > 0) {
+		return SDL_FALSE;
+	}
+	int num_keys = SDL_PeepEvents(events, sizeof(events) / sizeof(events[0]), SDL_PEEKEVENT, SDL_KEYDOWN, SDL_KEYDOWN);
+	for (int i = 0; i < num_keys; ++i) {
+		if (events[i].key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
+			return SDL_FALSE;
+		}
+	}
+
+	if (g_window) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, WINDOW_W, WINDOW_H);
+		glClearColor(0.15, 0.1, 0.3, 1.0);
+			glClear(GL_COLOR_BUFFER_BIT);
+		SDL_GL_SwapWindow(g_window);
+	}
+	return SDL_TRUE;
+}
+
+#ifndef __EMSCRIPTEN__
+// Presents frames at the target frame rate until every program is ready.
+// Returns: SDL_FALSE if asked to quit first.
+SDL_bool wait_for_program_builds(void)
+{
+	Uint64 next_frame = SDL_GetTicks64();
+	while (!program_builds_done()) {
+		if (SDL_GetTicks64() >= next_frame) {
+			if (!present_loading_frame()) {
+				return SDL_FALSE;
+			}
+			next_frame += 1000 / g_options.target_fps;
+		}
+		SDL_Delay(1);
+	}
+	return SDL_TRUE;
+}
+#endif
+
+// Returns: the pair path set by --backend, --fold-factor and --pair-block.
+PairPath option_pair_path(void)
+{
+	return (PairPath) { g_options.backend, g_options.fold_factor, g_options.pair_block };
+}
+
+// Collects the built programs, sets them up and spawns the starting planets.
+void finish_startup(void)
+{
+	for (int i = 0; i < NUM_PROGRAMS; ++i) {
+		const ProgramSpec *spec = &g_program_specs[i];
+		GLuint program = finish_program_build(&g_program_builds[i]);
+		if (program == 0) {
+			char msg[128];
+			snprintf(msg, sizeof(msg), "Failed to link %s and %s", spec->vert, spec->frag);
+			assert_or_cleanup(SDL_FALSE, msg, gl_get_error_stringified);
+		}
+		if (spec->program) {
+			*spec->program = program;
+		}
+		spec->setup(program);
+	}
+	g_pair_variants[g_gravity_enabled][g_contacts_enabled] = g_pair_program;
+	g_fold_variants[0] = (FoldVariant) { g_options.fold_factor, g_fold_program };
+	g_num_fold_variants = 1;
+	g_motion_variants[g_gravity_enabled][g_contacts_enabled] = g_motion_program;
+	write_log("Programs ready %" PRIu64 " ms after SDL_Init()\n", SDL_GetTicks64());
+	log_program_cache_stats();
+
+#ifndef __EMSCRIPTEN__
+	if (g_initial_state.num_planets > 0) {
+		for (int i = 0; i < g_initial_state.num_planets; ++i) {
+			Planet planet;
+			for (int j = 0; j < 4; ++j) {
+				planet.motion[j] = g_initial_state.motion[4 * i + j];
+			}
+			planet.record[0] = g_initial_state.records[2 * i];
+			planet.record[1] = g_initial_state.records[2 * i + 1];
+			upload_planet(&planet);
+		}
+		g_initial_step = g_initial_state.step;
+		free_snapshot(&g_initial_state);
+		return;
+	}
+#endif
 
-	create_planet(x_relative, y_relative, dx, dy, r, g, b);
+	create_planet(0.0, 0.0, 0.0, 0.0, 0.0, 0.8, 0.2, 1.0, 1.0);
+	for (int i = 1; i < g_options.num_planets; ++i) {
+		create_random_planet(my_rand() % WINDOW_W, my_rand() % WINDOW_H);
+	}
 }
 
-SDL_bool update(Uint64 delta)
+SDL_bool update(Uint64 delta_us)
 {
 	SDL_Event e;
-	while (SDL_PollEvent(&e)) {
+	while (poll_input_event(&e)) {
 		switch (e.type) {
 			case SDL_QUIT:
 				return SDL_TRUE;
@@ -119,6 +809,22 @@ SDL_bool update(Uint64 delta)
 					case SDL_SCANCODE_ESCAPE:
 						push_quit_event();
 						break;
+					case SDL_SCANCODE_F12:
+						gpu_timer_flush();
+						write_trace();
+						break;
+					case SDL_SCANCODE_G:
+						request_physics_variant(!g_requested_gravity, g_requested_contacts);
+						break;
+					case SDL_SCANCODE_C:
+						request_physics_variant(g_requested_gravity, !g_requested_contacts);
+						break;
+					case SDL_SCANCODE_P:
+						set_paused(!g_paused);
+						break;
+					case SDL_SCANCODE_N:
+						request_single_step();
+						break;
 					default:
 						break;
 				}
@@ -146,13 +852,31 @@ SDL_bool update(Uint64 delta)
 				break;
 			case SDL_MOUSEMOTION:
 				if (g_dragging_camera) {
+					// The only input drawn the same frame; the rest waits for a step
+					input_latency_mark(e.motion.timestamp);
 					g_camera[0] -= e.motion.xrel;
 					g_camera[1] -= e.motion.yrel;
-					glUniform2f(
-						glGetUniformLocation(g_draw_program, "camera"),
-						2.0 * (GLfloat)(g_camera[0]) / WINDOW_W,
-						-2.0 * (GLfloat)(g_camera[1]) / WINDOW_H
-					);
+					g_redraw_needed = SDL_TRUE;
+				}
+				break;
+			case SDL_WINDOWEVENT:
+				switch (e.window.event) {
+					case SDL_WINDOWEVENT_HIDDEN:
+					case SDL_WINDOWEVENT_MINIMIZED:
+						g_window_hidden = SDL_TRUE;
+						sync_sim_idle();
+						break;
+					case SDL_WINDOWEVENT_SHOWN:
+					case SDL_WINDOWEVENT_RESTORED:
+						g_window_hidden = SDL_FALSE;
+						sync_sim_idle();
+						g_redraw_needed = SDL_TRUE;
+						break;
+					case SDL_WINDOWEVENT_EXPOSED:
+						g_redraw_needed = SDL_TRUE;
+						break;
+					default:
+						break;
 				}
 				break;
 			default:
@@ -163,38 +887,49 @@ SDL_bool update(Uint64 delta)
 	return SDL_FALSE;
 }
 
-void resolve_intersections()
+// Returns: columns of the impulse texture the pair pass writes, one per block of
+// partners.
+int pair_columns(void)
+{
+	return (g_num_planets + g_pair_path.pair_block - 1) / g_pair_path.pair_block;
+}
+
+// Gravity and contacts for every pair in one pass, with whichever is disabled
+// compiled out of g_pair_program. Covers the rows of pairs for rows planets from
+// first_body, written from the top of the impulse texture.
+void resolve_pairs(int first_body, int rows)
 {
 	glActiveTexture(GL_TEXTURE0 + POSITION_TEX_UNIT_OFFSET);
 		glBindTexture(GL_TEXTURE_2D, g_motion_texture[g_motion_framebuffer_active]);
+	glActiveTexture(GL_TEXTURE0 + ATTRIBUTE_TEX_UNIT_OFFSET);
+		glBindTexture(GL_TEXTURE_2D, g_attribute_texture);
 
-	glUseProgram(g_intersection_program);
+	if (g_pair_uniforms_program != g_pair_program) {
+		g_pair_first_body_uniform = glGetUniformLocation(g_pair_program, "first_body");
+		g_pair_num_bodies_uniform = glGetUniformLocation(g_pair_program, "num_bodies");
+		g_pair_uniforms_program = g_pair_program;
+	}
+	glUseProgram(g_pair_program);
+		glUniform1i(g_pair_first_body_uniform, first_body);
+		glUniform1i(g_pair_num_bodies_uniform, g_num_planets);
 	glBindFramebuffer(GL_FRAMEBUFFER, g_impulse_framebuffer[g_impulse_framebuffer_active]);
-	glViewport(0, 0, g_num_planets, g_num_planets);
+	glViewport(0, 0, pair_columns(), rows);
 	// Need a valid VAO but doesn't matter which
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
-void calculate_gravity(void)
-{
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
-		glActiveTexture(GL_TEXTURE0 + POSITION_TEX_UNIT_OFFSET);
-			glBindTexture(GL_TEXTURE_2D, g_motion_texture[g_motion_framebuffer_active]);
-
-		glUseProgram(g_attraction_program);
-		glBindFramebuffer(GL_FRAMEBUFFER, g_impulse_framebuffer[g_impulse_framebuffer_active]);
-		glViewport(0, 0, g_num_planets, g_num_planets);
-		// Need a valid VAO but doesn't matter which
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-	glBlendFunc(GL_ONE, GL_ZERO); // default values
-	glDisable(GL_BLEND);
-}
-
-void fold_gravity_texture(void)
+// Sums the first rows rows of the impulse texture into their first column.
+void fold_gravity_texture(int rows)
 {
+	int columns = pair_columns();
+	int fold_step = g_pair_path.fold_factor;
+	if (g_fold_uniforms_program != g_fold_program) {
+		g_fold_input_columns_uniform = glGetUniformLocation(g_fold_program, "input_columns");
+		g_fold_uniforms_program = g_fold_program;
+	}
+	int input_columns = columns;
 	glUseProgram(g_fold_program);
-		for (int fold_factor = 4; fold_factor < g_num_planets * 4; fold_factor *= 4) {
+		for (int fold_factor = fold_step; fold_factor < columns * fold_step; fold_factor *= fold_step) {
 			glActiveTexture(GL_TEXTURE0 + FOLD_TEX_UNIT_OFFSET);
 				glBindTexture(GL_TEXTURE_2D, g_impulse_texture[g_impulse_framebuffer_active]);
 
@@ -202,16 +937,44 @@ void fold_gravity_texture(void)
 
 			glBindFramebuffer(GL_FRAMEBUFFER, g_impulse_framebuffer[g_impulse_framebuffer_active]);
 
-			glClearColor(0.0, 0.0, 0.0, 0.0);
-			glViewport(0, 0, g_num_planets, g_num_planets);
-				glClear(GL_COLOR_BUFFER_BIT);
-
-			glViewport(0, 0, (g_num_planets + fold_factor - 1) / fold_factor, g_num_planets);
+			// Reads stop at the last column written, so nothing needs clearing
+			glUniform1i(g_fold_input_columns_uniform, input_columns);
+			input_columns = (columns + fold_factor - 1) / fold_factor;
+			glViewport(0, 0, input_columns, rows);
 				glDrawArrays(GL_TRIANGLES, 0, 6);
 		}
 }
 
-void resolve_motion(GLfloat delta)
+// Evaluates the pair matrix --tile-rows rows at a time. Each strip is folded and
+// its sums copied into g_impulse_sum_texture before the next overwrites it, so the
+// impulse textures need only a strip's rows however many planets there are. Every
+// row sums in the same order as with the whole matrix.
+void resolve_pairs_in_strips(void)
+{
+	int strip_rows = SDL_min(g_options.tile_rows, g_impulse_rows);
+	for (int first_body = 0; first_body < g_num_planets; first_body += strip_rows) {
+		int rows = SDL_min(strip_rows, g_num_planets - first_body);
+		resolve_pairs(first_body, rows);
+		fold_gravity_texture(rows);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, g_impulse_framebuffer[g_impulse_framebuffer_active]);
+		glBindTexture(GL_TEXTURE_2D, g_impulse_sum_texture);
+			glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_body, 0, 0, 1, rows);
+	}
+}
+
+// Computes the summed impulse on every planet with the current pair path.
+void resolve_impulses(void)
+{
+	if (g_pair_path.backend == BACKEND_TILED) {
+		resolve_pairs_in_strips();
+	} else {
+		resolve_pairs(0, g_num_planets);
+		fold_gravity_texture(g_num_planets);
+	}
+}
+
+void resolve_motion(void)
 {
 	// Bind last frame's position texture to uniform slot
 	glActiveTexture(GL_TEXTURE0 + POSITION_TEX_UNIT_OFFSET);
@@ -219,345 +982,1322 @@ void resolve_motion(GLfloat delta)
 
 	// Bind flat attractions to uniform slot
 	glActiveTexture(GL_TEXTURE0 + ATTRACTION_TEX_UNIT_OFFSET);
+	if (g_pair_path.backend == BACKEND_TILED) {
+		glBindTexture(GL_TEXTURE_2D, g_impulse_sum_texture);
+	} else {
 		glBindTexture(GL_TEXTURE_2D, g_impulse_texture[g_impulse_framebuffer_active]);
+	}
 
 	glUseProgram(g_motion_program);
 	g_motion_framebuffer_active = (g_motion_framebuffer_active + 1) % 2;
 	glBindFramebuffer(GL_FRAMEBUFFER, g_motion_framebuffer[g_motion_framebuffer_active]);
 	glViewport(0, 0, g_num_planets, 1);
-		glUniform1f(glGetUniformLocation(g_motion_program, "time_step"), delta);
 		glDrawArrays(GL_LINES, 0, 2);
 }
 
-void gpu_update(Uint64 delta)
+// Returns: the fold program summing fold_factor columns a pass, built if need be, or
+// 0 if it fails to build.
+GLuint fold_program_for(int fold_factor)
 {
-	resolve_intersections();
-	calculate_gravity();
-	fold_gravity_texture();
-	resolve_motion((GLfloat)(delta) / 1000.0);
+	for (int i = 0; i < g_num_fold_variants; ++i) {
+		if (g_fold_variants[i].fold_factor == fold_factor) {
+			return g_fold_variants[i].program;
+		}
+	}
+	if (g_num_fold_variants >= MAX_FOLD_VARIANTS) {
+		return 0;
+	}
+
+	char defines[sizeof(g_fold_defines)];
+	snprintf(defines, sizeof(defines), "#define FOLD_FACTOR %d\n", fold_factor);
+	char *out = "out_sum";
+	GLuint program = load_program("quad.vert", "fold_texture.frag", defines, 1, &out, 0, NULL);
+	if (program == 0) {
+		write_log("Failed to build the fold program for a factor of %d\n", fold_factor);
+		return 0;
+	}
+	setup_fold_program(program);
+	g_fold_variants[g_num_fold_variants] = (FoldVariant) { fold_factor, program };
+	++g_num_fold_variants;
+	return program;
 }
 
-void draw(void)
+// Returns: the parked pair programs for pair_block, added if it's new, or NULL if
+// there's no room.
+PairBlockVariants *pair_block_variants(int pair_block)
 {
-	glClearColor(0.15, 0.1, 0.3, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, WINDOW_W, WINDOW_H);
-		glClear(GL_COLOR_BUFFER_BIT);
+	for (int i = 0; i < g_num_pair_block_variants; ++i) {
+		if (g_pair_block_variants[i].pair_block == pair_block) {
+			return &g_pair_block_variants[i];
+		}
+	}
+	if (g_num_pair_block_variants >= MAX_PAIR_BLOCK_VARIANTS) {
+		return NULL;
+	}
+	PairBlockVariants *variants = &g_pair_block_variants[g_num_pair_block_variants];
+	*variants = (PairBlockVariants) { pair_block };
+	++g_num_pair_block_variants;
+	return variants;
+}
 
-	glBindVertexArray(g_draw_vao);
-	glUseProgram(g_draw_program);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, WINDOW_W, WINDOW_H);
-		glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, CIRCLE_SIDES + 2, g_num_planets);
+// Switches to the pair program summing pair_block partners per fragment, with the
+// current physics features, building it on first use. The programs for the old
+// block are parked, so switching back doesn't recompile.
+// Returns: success; on failure the current program stays.
+SDL_bool use_pair_block(int pair_block)
+{
+	if (pair_block == g_pair_path.pair_block) {
+		return SDL_TRUE;
+	}
+	PairBlockVariants *parked = pair_block_variants(g_pair_path.pair_block);
+	PairBlockVariants *wanted = pair_block_variants(pair_block);
+	if (parked == NULL || wanted == NULL) {
+		return SDL_FALSE;
+	}
 
-	SDL_GL_SwapWindow(g_window);
+	GLuint *program = &wanted->programs[g_gravity_enabled][g_contacts_enabled];
+	if (*program == 0) {
+		char defines[sizeof(g_pair_defines)];
+		pair_defines(defines, sizeof(defines), g_gravity_enabled, g_contacts_enabled, pair_block);
+		char *out = "out_impulse";
+		*program = load_program("quad.vert", "resolve_pairs.frag", defines, 1, &out, 0, NULL);
+		if (*program == 0) {
+			write_log("Failed to build the pair program for a block of %d\n", pair_block);
+			return SDL_FALSE;
+		}
+		setup_pair_program(*program);
+	}
+	memcpy(parked->programs, g_pair_variants, sizeof(g_pair_variants));
+	memcpy(g_pair_variants, wanted->programs, sizeof(g_pair_variants));
+	g_pair_program = *program;
+	pair_defines(g_pair_defines, sizeof(g_pair_defines), g_gravity_enabled, g_contacts_enabled, pair_block);
+	return SDL_TRUE;
 }
 
-SDL_bool main_loop(Uint64 delta)
+// Switches the pair passes to path. Call from whichever thread steps the simulation.
+// Returns: success; on failure the current path stays.
+SDL_bool use_pair_path(const PairPath *path)
 {
-	SDL_bool loop_done = update(delta);
-	gpu_update(delta);
-	draw();
-	return loop_done;
+	if (path->backend == BACKEND_FRAGMENT && g_impulse_rows < g_max_planets) {
+		// There's no room for the whole matrix
+		return SDL_FALSE;
+	}
+	if ((g_max_planets + path->pair_block - 1) / path->pair_block > g_impulse_columns) {
+		// Nor for blocks this small
+		return SDL_FALSE;
+	}
+	GLuint fold_program = fold_program_for(path->fold_factor);
+	if (fold_program == 0 || !use_pair_block(path->pair_block)) {
+		return SDL_FALSE;
+	}
+	g_fold_program = fold_program;
+	g_pair_path = *path;
+	// For reloads, which rebuild whatever g_fold_defines describes
+	snprintf(g_fold_defines, sizeof(g_fold_defines), "#define FOLD_FACTOR %d\n", path->fold_factor);
+	return SDL_TRUE;
 }
 
-#ifdef __EMSCRIPTEN__
-void main_loop_emscripten(void)
+// One step's pair passes on path, for the autotuner. The impulses they leave are
+// overwritten by the next step, so the simulation is unaffected.
+// Returns: whether the path could be used.
+SDL_bool run_pair_path(const PairPath *path)
 {
-	SDL_bool loop_done = main_loop(16);
-	if (loop_done) {
-		emscripten_cancel_main_loop();
-		cleanup_and_quit(EXIT_SUCCESS);
+	if (!use_pair_path(path)) {
+		return SDL_FALSE;
 	}
+	resolve_impulses();
+	return SDL_TRUE;
 }
-#endif
 
-int main(int argc, char *argv[])
+// Once the planet count enters another power-of-two bucket, switches to the path
+// saved for it, or else times every candidate and keeps the fastest. Below the
+// smallest bucket, or without autotuning, uses --backend and --fold-factor. Call from
+// whichever thread steps the simulation, before its pair passes.
+void autotune_pair_path(void)
 {
-	my_srand(time(NULL));
-#ifdef DEBUG
-	open_log("planetarium.log");
-#endif
+	int bucket = autotune_bucket(g_num_planets);
+	if (bucket == g_autotune_bucket) {
+		return;
+	}
+	g_autotune_bucket = bucket;
+
+	PairPath path = option_pair_path();
+	if (bucket > 0
+		&& !autotune_lookup(bucket, &path)
+		&& !autotune_measure(bucket, g_pair_path_candidates, NUM_PAIR_PATH_CANDIDATES, run_pair_path, &path)
+	) {
+		path = option_pair_path();
+	}
+	if (!use_pair_path(&path)) {
+		PairPath fallback = option_pair_path();
+		use_pair_path(&fallback);
+	}
+}
 
-	assert_or_cleanup(
-		SDL_Init(SDL_INIT_VIDEO) == 0,
-		"Failed to init SDL subsystems",
-		SDL_GetError
-	);
-	push_cleanup_fn(SDL_Quit);
+// Writes this frame's values into the Frame uniform block shared by every program.
+void upload_frame_uniforms(Uint64 delta_us)
+{
+	g_frame_uniforms.camera[0] = 2.0 * (GLfloat)(g_camera[0]) / WINDOW_W;
+	g_frame_uniforms.camera[1] = -2.0 * (GLfloat)(g_camera[1]) / WINDOW_H;
+	g_frame_uniforms.time_step = (GLfloat)(delta_us) / 1000000.0;
 
-#ifdef __EMSCRIPTEN__
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
-#else
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
-#endif
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	g_window = SDL_CreateWindow(
-		"Particle gravity",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		WINDOW_W,
-		WINDOW_H,
-		SDL_WINDOW_OPENGL
-	);
-	assert_or_cleanup(g_window != NULL, "Failed to open window", SDL_GetError);
-	push_cleanup_fn(destroy_window);
-#ifndef DEBUG
-	register_message_window(g_window);
-#endif
+	glBindBuffer(GL_UNIFORM_BUFFER, g_frame_ubo);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(g_frame_uniforms), &g_frame_uniforms);
+}
 
-	g_glcontext = SDL_GL_CreateContext(g_window);
-	assert_or_cleanup(g_glcontext != NULL, "Failed to create OpenGL context", SDL_GetError);
-	push_cleanup_fn(delete_glcontext);
+void gpu_update(void)
+{
+	// With nothing acting between planets, the motion variant doesn't read impulses
+	if (g_gravity_enabled || g_contacts_enabled) {
+		autotune_pair_path();
+		if (g_pair_path.backend == BACKEND_TILED) {
+			// Strips alternate between the two passes, so they're timed as one
+			gpu_timer_begin(GPU_PASS_PAIRS);
+				resolve_pairs_in_strips();
+			gpu_timer_end(GPU_PASS_PAIRS);
+		} else {
+			gpu_timer_begin(GPU_PASS_PAIRS);
+				resolve_pairs(0, g_num_planets);
+			gpu_timer_end(GPU_PASS_PAIRS);
+			gpu_timer_begin(GPU_PASS_FOLD);
+				fold_gravity_texture(g_num_planets);
+			gpu_timer_end(GPU_PASS_FOLD);
+		}
+	}
+	gpu_timer_begin(GPU_PASS_MOTION);
+		resolve_motion();
+	gpu_timer_end(GPU_PASS_MOTION);
+}
 
-#ifdef __EMSCRIPTEN__
-	const GLubyte *gl_version_str = glGetString(GL_VERSION);
-	write_log("%s\n", gl_version_str);
-	assert_or_cleanup(have_webgl_2((const char *) gl_version_str), "This browser does not support WebGL 2.0", gl_get_error_stringified);
-#else
-	int gl_version = gladLoadGL((GLADloadfunc) SDL_GL_GetProcAddress);
-	assert_or_cleanup(gl_version != 0, "Failed to load OpenGL functions", NULL);
-	write_log("OpenGL version %d.%d\n", GLAD_VERSION_MAJOR(gl_version), GLAD_VERSION_MINOR(gl_version));
+// Steps the simulation on this thread for a frame delta_us long: once, or with
+// --sim-rate as many whole steps as the time banked so far covers. Any left over
+// carries to the next frame, and sets how far past the latest step to draw.
+void run_frame_steps(Uint64 delta_us)
+{
+	int steps = 1;
+	Uint64 step_us = delta_us;
+	g_frame_uniforms.interpolation = 1.0;
+	g_frame_uniforms.interpolated_bodies = g_num_planets;
+	if (g_sim_step_us > 0) {
+		g_sim_accumulator_us += delta_us;
+		// If too far behind to catch up, the simulation slows down instead
+		steps = SDL_min(g_sim_accumulator_us / g_sim_step_us, MAX_STEPS_PER_FRAME);
+		g_sim_accumulator_us %= g_sim_step_us;
+		step_us = g_sim_step_us;
+		g_frame_uniforms.interpolation = (GLfloat)(g_sim_accumulator_us) / g_sim_step_us;
+	}
 
-	#ifdef DEBUG
-		if (!have_gl_debug_output(gl_version)) {
-			write_log("GL_DEBUG_OUTPUT unavailable\n");
-		} else {
-			write_log("Enabling GL_DEBUG_OUTPUT\n");
-			glEnable(GL_DEBUG_OUTPUT);
-			glDebugMessageCallback(gl_debug_message_callback, NULL);
+	upload_frame_uniforms(step_us);
+	for (int i = 0; i < steps; ++i) {
+		gpu_update();
+	}
+}
+
+#ifndef __EMSCRIPTEN__
+// Lists the planets that overlap the screen in g_visible_vbo, in planet order, and
+// sets up g_draw_command_buffer to draw them. The count stays on the GPU.
+void cull_bodies(GLuint vertices_per_body, int num_planets)
+{
+	const GLuint command[4] = { vertices_per_body, 0, 0, 0 };
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_draw_command_buffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), command);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_STORAGE_BINDING, g_visible_vbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_STORAGE_BINDING, g_draw_command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GROUP_STORAGE_BINDING, g_cull_group_buffer);
+	GLuint num_groups = (num_planets + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+	glUseProgram(g_cull_program);
+		glUniform1i(g_cull_num_bodies_uniform, num_planets);
+		// Count each group's visible planets, then find where each group's start
+		glUniform1i(g_cull_stage_uniform, CULL_COUNT);
+		glDispatchCompute(num_groups, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		glUniform1i(g_cull_stage_uniform, CULL_SCAN);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		glUniform1i(g_cull_stage_uniform, CULL_WRITE);
+		glDispatchCompute(num_groups, 1, 1);
+
+	// The draw reads the list as vertex attributes and the count as its command
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+#endif
+
+// Returns: the renderer chosen with --renderer, or the density map once there are
+// too many planets to be worth drawing one by one.
+Renderer current_renderer(int num_planets)
+{
+	Renderer renderer = g_options.renderer;
+	if (g_options.splat_threshold > 0 && num_planets > g_options.splat_threshold) {
+		renderer = RENDERER_SPLAT;
+	}
+	if (renderer != g_last_renderer) {
+		write_log("Drawing %d planets with the %s renderer\n", num_planets, renderer_names[renderer]);
+		g_last_renderer = renderer;
+	}
+	return renderer;
+}
+
+// Spreads the density map over the screen, tone mapped onto the background.
+void resolve_splats(void)
+{
+	glActiveTexture(GL_TEXTURE0 + SPLAT_TEX_UNIT_OFFSET);
+		glBindTexture(GL_TEXTURE_2D, g_splat_texture);
+
+	glUseProgram(g_resolve_splat_program);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_screen_framebuffer);
+	glViewport(0, 0, WINDOW_W, WINDOW_H);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDisable(GL_BLEND);
+}
+
+void draw(void)
+{
+	// The two latest steps, whichever thread ran them. main_loop() has already said
+	// how far between them to draw if they were run here.
+	GLuint positions = g_motion_texture[g_motion_framebuffer_active];
+	GLuint previous_positions = g_motion_texture[(g_motion_framebuffer_active + 1) % 2];
+	int num_planets = g_num_planets;
+	if (g_sim_thread) {
+		ExchangedState state;
+		state_exchange_begin_read(&state);
+		positions = state.current;
+		previous_positions = state.previous;
+		num_planets = state.num_planets;
+
+		g_frame_uniforms.interpolation = state.interpolation;
+		g_frame_uniforms.interpolated_bodies = state.num_previous_planets;
+		glBindBuffer(GL_UNIFORM_BUFFER, g_frame_ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(g_frame_uniforms), &g_frame_uniforms);
+	}
+
+	Renderer renderer = current_renderer(num_planets);
+	glActiveTexture(GL_TEXTURE0 + POSITION_TEX_UNIT_OFFSET);
+		glBindTexture(GL_TEXTURE_2D, positions);
+	glActiveTexture(GL_TEXTURE0 + PREVIOUS_POSITION_TEX_UNIT_OFFSET);
+		glBindTexture(GL_TEXTURE_2D, previous_positions);
+	glActiveTexture(GL_TEXTURE0 + ATTRIBUTE_TEX_UNIT_OFFSET);
+		glBindTexture(GL_TEXTURE_2D, g_attribute_texture);
+	GLenum mode = GL_TRIANGLE_FAN;
+	GLuint vertices_per_body = CIRCLE_SIDES + 2;
+	if (renderer == RENDERER_SPRITE) {
+		// Four vertices a planet; edges blend into the background
+		mode = GL_TRIANGLE_STRIP;
+		vertices_per_body = 4;
+	} else if (renderer == RENDERER_SPLAT) {
+		// Cost is one vertex and a few texels a planet, however many overlap
+		mode = GL_POINTS;
+		vertices_per_body = 1;
+	}
+
+	if (g_culling) {
+#ifndef __EMSCRIPTEN__
+		gpu_timer_begin(GPU_PASS_CULL);
+			cull_bodies(vertices_per_body, num_planets);
+		gpu_timer_end(GPU_PASS_CULL);
+#endif
+	}
+
+	gpu_timer_begin(GPU_PASS_DRAW);
+	glClearColor(0.15, 0.1, 0.3, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_screen_framebuffer);
+	glViewport(0, 0, WINDOW_W, WINDOW_H);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+	if (renderer == RENDERER_SPLAT) {
+		glBindVertexArray(g_splat_vao);
+		glUseProgram(g_splat_program);
+		glBindFramebuffer(GL_FRAMEBUFFER, g_splat_framebuffer);
+		glViewport(0, 0, WINDOW_W / SPLAT_DOWNSCALE, WINDOW_H / SPLAT_DOWNSCALE);
+		glClearColor(0.0, 0.0, 0.0, 0.0);
+			glClear(GL_COLOR_BUFFER_BIT);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+	} else if (renderer == RENDERER_SPRITE) {
+		glBindVertexArray(g_sprite_vao);
+		glUseProgram(g_sprite_program);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	} else {
+		glBindVertexArray(g_draw_vao);
+		glUseProgram(g_draw_program);
+	}
+	if (g_culling) {
+#ifndef __EMSCRIPTEN__
+		glDrawArraysIndirect(mode, (void *) 0);
+#endif
+	} else {
+		glDrawArraysInstanced(mode, 0, vertices_per_body, num_planets);
+	}
+	glDisable(GL_BLEND);
+
+	if (renderer == RENDERER_SPLAT) {
+		resolve_splats();
+	}
+	gpu_timer_end(GPU_PASS_DRAW);
+	if (g_sim_thread) {
+		state_exchange_end_read();
+	}
+
+	if (g_window) {
+		trace_begin(TRACE_SWAP);
+			SDL_GL_SwapWindow(g_window);
+		trace_end(TRACE_SWAP);
+	}
+}
+
+#ifdef HAVE_INOTIFY
+// Deletes a program that a reload has replaced. While the simulation thread runs,
+// programs linked in one context may have been used in the other, and deleting
+// those has crashed Mesa's llvmpipe; they're left for context teardown instead.
+void delete_replaced_program(GLuint program)
+{
+	if (g_sim_thread == NULL) {
+		glDeleteProgram(program);
+	}
+}
+
+// Rebuilds every program that uses a shader saved since the last frame (all of them
+// for SHADER_PRELUDE), and sets it up as at startup. Simulation state is untouched. If the new source doesn't build,
+// the error is logged and the old program stays in use.
+void reload_changed_shaders(void)
+{
+	char name[64];
+	while (next_changed_shader(name, sizeof(name))) {
+		if (g_sim_thread) {
+			SDL_LockMutex(g_sim_lock);
 		}
-	#endif
+		for (int i = 0; i < NUM_PROGRAMS; ++i) {
+			const ProgramSpec *spec = &g_program_specs[i];
+			if (strcmp(name, spec->vert) != 0 && strcmp(name, spec->frag) != 0 && strcmp(name, SHADER_PRELUDE) != 0) {
+				continue;
+			}
+
+			char *outs[] = { spec->out };
+			const char *transforms[] = { spec->transform };
+			GLuint program = load_program(
+				spec->vert,
+				spec->frag,
+				spec->defines,
+				spec->out ? 1 : 0,
+				outs,
+				spec->transform ? 1 : 0,
+				transforms
+			);
+			if (program == 0) {
+				write_log("Keeping previous %s + %s\n", spec->vert, spec->frag);
+				continue;
+			}
+			write_log("Reloaded %s + %s\n", spec->vert, spec->frag);
+			g_redraw_needed = SDL_TRUE;
+
+			if (spec->program) {
+				if (spec->variants) {
+					// Other specialisations are stale now; they'll be rebuilt if used
+					for (int g = 0; g < 2; ++g) {
+						for (int c = 0; c < 2; ++c) {
+							if (spec->variants[g][c] != *spec->program) {
+								delete_replaced_program(spec->variants[g][c]);
+							}
+							spec->variants[g][c] = 0;
+						}
+					}
+					spec->variants[g_gravity_enabled][g_contacts_enabled] = program;
+				}
+				if (spec->program == &g_fold_program) {
+					// As above, for the other fold factors
+					for (int v = 0; v < g_num_fold_variants; ++v) {
+						if (g_fold_variants[v].program != *spec->program) {
+							delete_replaced_program(g_fold_variants[v].program);
+						}
+					}
+					g_fold_variants[0] = (FoldVariant) { g_pair_path.fold_factor, program };
+					g_num_fold_variants = 1;
+				}
+				if (spec->program == &g_pair_program) {
+					// And for the other pair blocks; the current one's entry is only a copy
+					for (int v = 0; v < g_num_pair_block_variants; ++v) {
+						PairBlockVariants *variants = &g_pair_block_variants[v];
+						for (int g = 0; g < 2; ++g) {
+							for (int c = 0; c < 2; ++c) {
+								if (variants->pair_block != g_pair_path.pair_block) {
+									delete_replaced_program(variants->programs[g][c]);
+								}
+								variants->programs[g][c] = 0;
+							}
+						}
+					}
+				}
+				delete_replaced_program(*spec->program);
+				*spec->program = program;
+			}
+			spec->setup(program);
+		}
+		for (int i = 0; i < NUM_COMPUTE_PROGRAMS; ++i) {
+			const ComputeProgramSpec *spec = &g_compute_program_specs[i];
+			if (*spec->program == 0 || (strcmp(name, spec->comp) != 0 && strcmp(name, SHADER_PRELUDE) != 0)) {
+				continue;
+			}
+
+			GLuint program = load_compute_program(spec->comp, spec->defines);
+			if (program == 0) {
+				write_log("Keeping previous %s\n", spec->comp);
+				continue;
+			}
+			write_log("Reloaded %s\n", spec->comp);
+			g_redraw_needed = SDL_TRUE;
+			delete_replaced_program(*spec->program);
+			*spec->program = program;
+			spec->setup(program);
+		}
+		if (g_sim_thread) {
+			// The simulation context only sees the new programs once they're built
+			glFinish();
+			SDL_UnlockMutex(g_sim_lock);
+		}
+	}
+}
 #endif
 
-	glGenVertexArrays(1, &g_draw_vao);
-	glBindVertexArray(g_draw_vao);
+// Attaches the motion and impulse textures to framebuffers in the current context.
+void create_simulation_framebuffers(void)
+{
+	glGenFramebuffers(2, g_motion_framebuffer);
+	glGenFramebuffers(2, g_impulse_framebuffer);
+	for (int i = 0; i < 2; ++i) {
+		glBindFramebuffer(GL_FRAMEBUFFER, g_motion_framebuffer[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_motion_texture[i], 0);
+			assert_or_cleanup(
+				glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
+				"Planet position framebuffer incomplete",
+				gl_get_error_stringified
+			);
 
-	// Ensure buffers that won't immediately be overwritten are set to zero
-	GLfloat zeroes[4 * MAX_PLANETS];
-	for (int i = 0; i < sizeof(zeroes) / sizeof(zeroes[0]); ++i) {
-		zeroes[i] = 0.0;
+		glBindFramebuffer(GL_FRAMEBUFFER, g_impulse_framebuffer[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_impulse_texture[i], 0);
+			assert_or_cleanup(
+				glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
+				"Attraction matrix framebuffer incomplete",
+				gl_get_error_stringified
+			);
 	}
+}
 
-	glGenBuffers(1, &g_circle_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, g_circle_vbo);
-		glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(float) * (CIRCLE_SIDES + 2), NULL, GL_STATIC_DRAW);
+#ifndef __EMSCRIPTEN__
+// Makes context current on the calling thread, or releases the thread's context if
+// context is NULL.
+// Returns: success.
+SDL_bool make_context_current(SDL_GLContext context)
+{
+#ifdef HAVE_EGL
+	if (g_options.headless) {
+		return make_headless_context_current(context);
+	}
+#endif
+	return SDL_GL_MakeCurrent(g_window, context) == 0;
+}
 
-	glGenBuffers(1, &g_colour_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, g_colour_vbo);
-		glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(GLfloat) * MAX_PLANETS, zeroes, GL_DYNAMIC_DRAW);
+// Returns: a new context sharing textures, buffers, programs and sync objects with
+// g_glcontext, or NULL on failure. g_glcontext stays current.
+SDL_GLContext create_shared_context(void)
+{
+#ifdef HAVE_EGL
+	if (g_options.headless) {
+		return create_shared_headless_context();
+	}
+#endif
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	SDL_GLContext context = SDL_GL_CreateContext(g_window);
+	// Creating a context makes it current
+	SDL_GL_MakeCurrent(g_window, g_glcontext);
+	return context;
+}
 
-	GLuint circle_shaders[2]; // vertex, fragment
+// Adds the planets queued by create_planet() and makes the physics switch asked for
+// by request_physics_variant(). Call on the simulation thread with g_sim_lock held.
+void apply_sim_requests(void)
+{
+	for (int i = 0; i < g_num_queued_planets; ++i) {
+		upload_planet(&g_queued_planets[i]);
+	}
+	g_num_queued_planets = 0;
 
-	circle_shaders[0] = load_shader("shaders/init_circle.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(circle_shaders[0] != 0, "Failed to load circle init vert shader", NULL);
+	if (g_physics_requested) {
+		use_physics_variant(g_requested_gravity, g_requested_contacts);
+		g_physics_requested = SDL_FALSE;
+	}
+}
 
-	circle_shaders[1] = load_shader("shaders/init_circle.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(circle_shaders[1] != 0, "Failed to load circle init frag shader", NULL);
+// Copies the newest positions into a texture for draw() to pick up; see
+// state_exchange_end_write() for settled.
+void publish_positions(SDL_bool settled)
+{
+	GLuint texture = state_exchange_begin_write();
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_motion_framebuffer[g_motion_framebuffer_active]);
+	glBindTexture(GL_TEXTURE_2D, texture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, g_num_planets, 1);
+	state_exchange_end_write(g_num_planets, settled);
+}
 
-	const char *init_circle_tfs[] = { "position" };
-	GLuint init_circle_program = create_shader_program(2, circle_shaders, 0, NULL, 1, init_circle_tfs);
-	assert_or_cleanup(init_circle_program != 0, "Failed to create circle init program", gl_get_error_stringified);
+// Wakes the main thread if it's idle in SDL_WaitEventTimeout(), so that it draws
+// what has just been published.
+void wake_main_thread(void)
+{
+	if (g_sim_published_event != (Uint32) -1) {
+		SDL_Event e = { .type = g_sim_published_event };
+		SDL_PushEvent(&e);
+	}
+}
 
-	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, g_circle_vbo);
-	glUseProgram(init_circle_program);
-		glUniform1i(glGetUniformLocation(init_circle_program, "num_sides"), CIRCLE_SIDES);
+// Steps the simulation at --sim-rate until g_sim_quit is set. The passes are the
+// ones in gpu_update(), without its timers: the queries belong to the main context.
+int simulation_thread(void *data)
+{
+	make_context_current(g_sim_context);
+	int sim_rate = g_options.sim_rate > 0 ? g_options.sim_rate : g_options.target_fps;
+	FramePacer pacer;
+	init_frame_pacer(&pacer, sim_rate, 0);
+	// Whether the thread has waited idle since it last published a step, so that the
+	// first step after resuming isn't drawn as if it took the whole pause
+	SDL_bool waited = SDL_FALSE;
+
+	while (!SDL_AtomicGet(&g_sim_quit)) {
+		Uint64 delta_us = frame_pacer_begin_frame(&pacer);
+		if (g_options.fixed_delta > 0) {
+			delta_us = g_options.fixed_delta * 1000;
+		}
+		g_sim_frame_uniforms.time_step = (GLfloat)(delta_us) / 1000000.0;
+
+		SDL_LockMutex(g_sim_lock);
+			if (g_sim_idle && g_sim_pending_steps == 0 && !SDL_AtomicGet(&g_sim_quit)) {
+				// Planets added while idle still appear, without a step
+				if (g_num_queued_planets > 0) {
+					apply_sim_requests();
+					publish_positions(SDL_TRUE);
+					wake_main_thread();
+				}
+				SDL_CondWait(g_sim_wake, g_sim_lock);
+				waited = SDL_TRUE;
+				SDL_UnlockMutex(g_sim_lock);
+				frame_pacer_skip(&pacer);
+				continue;
+			}
+			if (g_sim_idle) {
+				--g_sim_pending_steps;
+				g_sim_frame_uniforms.time_step = (GLfloat)(single_step_us()) / 1000000.0;
+			}
+			apply_sim_requests();
+			glBindBuffer(GL_UNIFORM_BUFFER, g_sim_frame_ubo);
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(g_sim_frame_uniforms), &g_sim_frame_uniforms);
+			if (g_gravity_enabled || g_contacts_enabled) {
+				// Under the lock, which keeps reloads from swapping programs mid-measurement
+				autotune_pair_path();
+				resolve_impulses();
+			}
+			resolve_motion();
+			publish_positions(g_sim_idle || waited);
+			waited = SDL_FALSE;
+			if (g_sim_idle) {
+				wake_main_thread();
+			}
+			GLsync step_done = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		SDL_UnlockMutex(g_sim_lock);
+
+		// Stay within a step of the GPU rather than queueing work faster than it runs
+		glClientWaitSync(step_done, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(step_done);
+
+		frame_pacer_wait(&pacer);
+	}
 
-		glEnable(GL_RASTERIZER_DISCARD);
-			glBeginTransformFeedback(GL_POINTS);
-				glDrawArrays(GL_POINTS, 0, CIRCLE_SIDES + 2);
-			glEndTransformFeedback();
-		glDisable(GL_RASTERIZER_DISCARD);
-	// WebGL exhibits undefined behaviour if a buffer in use is also bound as TFBO
-	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	log_frame_pacer_stats(&pacer, "simulation steps");
+	make_context_current(NULL);
+	return 0;
+}
 
-	GLuint draw_shaders[2]; // vertex, fragment
+// Stops the simulation thread and releases its context.
+void stop_sim_thread(void)
+{
+	if (g_sim_thread) {
+		SDL_AtomicSet(&g_sim_quit, 1);
+		SDL_LockMutex(g_sim_lock);
+			SDL_CondSignal(g_sim_wake);
+		SDL_UnlockMutex(g_sim_lock);
+		SDL_WaitThread(g_sim_thread, NULL);
+		g_sim_thread = NULL;
+	}
+	if (g_sim_context) {
+#ifdef HAVE_EGL
+		if (g_options.headless) {
+			destroy_shared_headless_context(g_sim_context);
+		} else {
+			SDL_GL_DeleteContext(g_sim_context);
+		}
+#else
+		SDL_GL_DeleteContext(g_sim_context);
+#endif
+		g_sim_context = NULL;
+	}
+	SDL_DestroyCond(g_sim_wake);
+	g_sim_wake = NULL;
+	SDL_DestroyMutex(g_sim_lock);
+	g_sim_lock = NULL;
+}
 
-	draw_shaders[0] = load_shader("shaders/particles.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(draw_shaders[0] != 0, "Failed to load draw vertex shader", NULL);
+// Moves the simulation passes onto their own thread and GL context, leaving this
+// one to handle input and draw.
+// Returns: success; on failure the simulation stays on this thread.
+SDL_bool start_sim_thread(void)
+{
+	if (!init_state_exchange(g_max_planets)) {
+		return SDL_FALSE;
+	}
+	g_sim_context = create_shared_context();
+	if (g_sim_context == NULL) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(stop_sim_thread);
+	g_sim_lock = SDL_CreateMutex();
+	g_sim_wake = SDL_CreateCond();
+	if (g_sim_lock == NULL || g_sim_wake == NULL) {
+		return SDL_FALSE;
+	}
+	g_sim_published_event = SDL_RegisterEvents(1);
+
+	// Everything uploaded so far has to be finished before the other context reads it
+	glDeleteFramebuffers(2, g_motion_framebuffer);
+	glDeleteFramebuffers(2, g_impulse_framebuffer);
+	glFinish();
+
+	assert_or_cleanup(make_context_current(g_sim_context), "Failed to switch to simulation context", SDL_GetError);
+		create_simulation_framebuffers();
+		glGenVertexArrays(1, &g_sim_vao);
+		glBindVertexArray(g_sim_vao);
+
+		g_sim_frame_uniforms = g_frame_uniforms;
+		glGenBuffers(1, &g_sim_frame_ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, g_sim_frame_ubo);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(g_sim_frame_uniforms), &g_sim_frame_uniforms, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, g_sim_frame_ubo);
+
+		// So that the first frame has something to draw
+		publish_positions(SDL_TRUE);
+		glFinish();
+	assert_or_cleanup(make_context_current(g_glcontext), "Failed to switch back to main context", SDL_GetError);
+
+	g_sim_thread = SDL_CreateThread(simulation_thread, "simulation", NULL);
+	assert_or_cleanup(g_sim_thread != NULL, "Failed to start simulation thread", SDL_GetError);
+	return SDL_TRUE;
+}
+#endif
 
-	draw_shaders[1] = load_shader("shaders/particles.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(draw_shaders[1] != 0, "Failed to load draw fragment shader", NULL);
+#ifndef __EMSCRIPTEN__
+// Writes the planets as of the latest step to <--snapshot-prefix>-<step>.txt.
+void write_planet_snapshot(Uint64 step)
+{
+	Snapshot snapshot;
+	if (!alloc_snapshot(&snapshot, g_num_planets)) {
+		write_log("Out of memory for snapshot at step %" PRIu64 "\n", step);
+		return;
+	}
+	snapshot.step = step;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_motion_framebuffer[g_motion_framebuffer_active]);
+		glReadPixels(0, 0, g_num_planets, 1, GL_RGBA, GL_FLOAT, snapshot.motion);
+
+	// Integer textures only read back as four channels, so widen and then compact
+	GLuint *records = my_malloc(sizeof(GLuint) * 4 * g_num_planets);
+	if (records) {
+		GLuint framebuffer;
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_attribute_texture, 0);
+			glReadPixels(0, 0, g_num_planets, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, records);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		for (int i = 0; i < g_num_planets; ++i) {
+			snapshot.records[2 * i] = records[4 * i];
+			snapshot.records[2 * i + 1] = records[4 * i + 1];
+		}
+		my_free(records);
 
-	char *outs = "out_color";
-	g_draw_program = create_shader_program(2, draw_shaders, 1, &outs, 0, NULL);
-	assert_or_cleanup(g_draw_program != 0, "Failed to create draw shader program", gl_get_error_stringified);
+		char fname[1024];
+		snprintf(fname, sizeof(fname), "%s-%08" PRIu64 ".txt", g_options.snapshot_prefix, step);
+		if (!write_snapshot(fname, &snapshot)) {
+			write_log("Failed to write snapshot %s\n", fname);
+		}
+	} else {
+		write_log("Out of memory for snapshot at step %" PRIu64 "\n", step);
+	}
+	free_snapshot(&snapshot);
+}
 
-	glUseProgram(g_draw_program);
-	glBindVertexArray(g_draw_vao);
-		glUniform1i(glGetUniformLocation(g_draw_program, "positions"), POSITION_TEX_UNIT_OFFSET);
-		glUniform1f(glGetUniformLocation(g_draw_program, "planet_r"), POINT_RADIUS);
+// Returns: whether the batch has been asked to stop, e.g. by Ctrl-C.
+SDL_bool batch_interrupted(void)
+{
+	SDL_Event e;
+	while (SDL_PollEvent(&e)) {
+		if (e.type == SDL_QUIT) {
+			return SDL_TRUE;
+		}
+	}
+	return SDL_FALSE;
+}
 
-		GLint in_vertex = glGetAttribLocation(g_draw_program, "vert_displacement");
-		GLint in_color_draw = glGetAttribLocation(g_draw_program, "color");
+// Simulates --batch steps of --fixed-dt back to back, with nothing drawn and no
+// frame pacing, then prints how fast they ran. Snapshots are written between steps
+// and the time they take is left out of the rates.
+void run_batch(void)
+{
+	write_log(
+		"Simulating %" PRIu64 " steps of %" PRIu64 " ms with %d planets\n",
+		g_options.batch_steps,
+		g_options.fixed_delta,
+		g_num_planets
+	);
+	upload_frame_uniforms(g_options.fixed_delta * 1000);
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 snapshot_ticks = 0;
+	Uint64 steps = 0;
+	while (steps < g_options.batch_steps) {
+		gpu_timer_begin_frame();
+		gpu_update();
+		++steps;
+
+		if (g_options.snapshot_every > 0 && steps % g_options.snapshot_every == 0) {
+			// Finish the steps first, so that their time isn't counted as the snapshot's
+			glFinish();
+			Uint64 snapshot_start = SDL_GetPerformanceCounter();
+			write_planet_snapshot(g_initial_step + steps);
+			snapshot_ticks += SDL_GetPerformanceCounter() - snapshot_start;
+		}
+		if (steps % BATCH_POLL_STEPS == 0 && batch_interrupted()) {
+			write_log("Batch interrupted after %" PRIu64 " steps\n", steps);
+			break;
+		}
+	}
+	glFinish();
+
+	double seconds = (double) (SDL_GetPerformanceCounter() - start - snapshot_ticks) / SDL_GetPerformanceFrequency();
+	double steps_per_s = steps / seconds;
+	double pairs_per_step = (double) g_num_planets * (g_num_planets - 1);
+	printf(
+		"%" PRIu64 " steps with %d planets in %.3f s: %.2f steps/s, %.4g pair interactions/s\n",
+		steps,
+		g_num_planets,
+		seconds,
+		steps_per_s,
+		steps_per_s * pairs_per_step
+	);
+	fflush(stdout);
+	gpu_timer_flush();
+}
+#endif
 
-		glEnableVertexAttribArray(in_vertex);
-		glEnableVertexAttribArray(in_color_draw);
-		glVertexAttribDivisor(in_color_draw, 1);
+// Runs one frame, simulating delta_us microseconds.
+// Returns: whether the program should quit.
+SDL_bool main_loop(Uint64 delta_us)
+{
+	if (g_options.fixed_delta > 0) {
+		delta_us = g_options.fixed_delta * 1000;
+	}
+	delta_us = replay_frame_delta(delta_us);
+	trace_begin_frame();
+	gpu_timer_begin_frame();
+	trace_begin(TRACE_FRAME);
+
+#ifndef __EMSCRIPTEN__
+	// Before reading input, so that it's as fresh as the wait allows
+	trace_begin(TRACE_GPU_WAIT);
+		frame_fences_wait();
+	trace_end(TRACE_GPU_WAIT);
+#endif
+	input_latency_poll();
 
-		glBindBuffer(GL_ARRAY_BUFFER, g_circle_vbo);
-			glVertexAttribPointer(in_vertex, 2, GL_FLOAT, GL_FALSE, 0, 0);
+#ifdef HAVE_INOTIFY
+	if (g_options.watch_shaders) {
+		reload_changed_shaders();
+	}
+#endif
 
-		glBindBuffer(GL_ARRAY_BUFFER, g_colour_vbo);
-			glVertexAttribPointer(in_color_draw, 4, GL_FLOAT, GL_FALSE, 0, 0);
+	trace_begin(TRACE_UPDATE);
+		SDL_bool loop_done = update(delta_us);
+	trace_end(TRACE_UPDATE);
+
+	trace_begin(TRACE_GPU_UPDATE);
+	if (simulation_idle()) {
+		if (g_pending_steps > 0) {
+			// Show each single step as it lands
+			g_frame_uniforms.interpolation = 1.0;
+			g_frame_uniforms.interpolated_bodies = g_num_planets;
+			g_redraw_needed = SDL_TRUE;
+		}
+		upload_frame_uniforms(single_step_us());
+		for (; g_pending_steps > 0; --g_pending_steps) {
+			gpu_update();
+		}
+	} else if (g_options.bench) {
+		upload_frame_uniforms(delta_us);
+		Uint64 step_start = SDL_GetPerformanceCounter();
+		gpu_update();
+		// Wait for the GPU, so that this times the step and not just its submission
+		glFinish();
+		bench_add_step(SDL_GetPerformanceCounter() - step_start);
+	} else if (g_sim_thread == NULL) {
+		run_frame_steps(delta_us);
+	} else {
+		upload_frame_uniforms(delta_us);
+	}
+	trace_end(TRACE_GPU_UPDATE);
 
-	GLuint motion_shaders[2]; // vertex, fragment
+	SDL_bool redraw = !simulation_idle() || g_redraw_needed;
+#ifndef __EMSCRIPTEN__
+	redraw = redraw || (g_sim_thread && state_exchange_has_new());
+#endif
+	SDL_bool hidden = g_window_hidden && g_options.background_throttle;
+	if ((!g_options.headless || g_options.offscreen) && redraw && !hidden) {
+		trace_begin(TRACE_DRAW);
+			draw();
+		trace_end(TRACE_DRAW);
+		g_redraw_needed = SDL_FALSE;
+	}
 
-	motion_shaders[0] = load_shader("shaders/line.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(motion_shaders[0] != 0, "Failed to load motion resolution vertex shader", NULL);
+	input_latency_end_frame();
+#ifndef __EMSCRIPTEN__
+	frame_fences_end_frame();
+#endif
 
-	motion_shaders[1] = load_shader("shaders/resolve_motion.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(motion_shaders[1] != 0, "Failed to load motion resolution fragment shader", NULL);
+	++g_frames_run;
+	if (g_options.max_frames > 0 && g_frames_run >= g_options.max_frames) {
+		loop_done = SDL_TRUE;
+	}
+	trace_end(TRACE_FRAME);
+	return loop_done;
+}
 
-	char *outs_update = "out_position";
-	g_motion_program = create_shader_program(2, motion_shaders, 1, &outs_update, 0, NULL);
-	assert_or_cleanup(g_motion_program != 0, "Failed to create update shader program", gl_get_error_stringified);
+#ifdef __EMSCRIPTEN__
+void main_loop_emscripten(void)
+{
+	// The browser only presents between calls, so wait for programs one frame at a time
+	static SDL_bool started = SDL_FALSE;
+	if (!started) {
+		if (!present_loading_frame()) {
+			emscripten_cancel_main_loop();
+			cleanup_and_quit(EXIT_SUCCESS);
+		}
+		if (!program_builds_done()) {
+			return;
+		}
+		finish_startup();
+		started = SDL_TRUE;
+	}
 
-	glUseProgram(g_motion_program);
-		glUniform1i(glGetUniformLocation(g_motion_program, "positions"), POSITION_TEX_UNIT_OFFSET);
-		glUniform1i(glGetUniformLocation(g_motion_program, "attractions"), ATTRACTION_TEX_UNIT_OFFSET);
+	SDL_bool loop_done = main_loop(16000);
+	if (loop_done) {
+		emscripten_cancel_main_loop();
+		cleanup_and_quit(EXIT_SUCCESS);
+	}
+}
+#endif
 
-	// Flat n * 1 texture of all planet positions
-	glGenTextures(2, g_motion_texture);
-	glGenFramebuffers(2, g_motion_framebuffer);
+int main(int argc, char *argv[])
+{
+	if (!parse_options(argc, argv)) {
+		return EXIT_FAILURE;
+	}
 
-	for (int i = 0; i < 2; ++i) {
-		glBindTexture(GL_TEXTURE_2D, g_motion_texture[i]);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, MAX_PLANETS, 1, 0, GL_RGBA, GL_FLOAT, NULL);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+#ifdef DEBUG
+	open_log("planetarium.log");
+#endif
 
-		glBindFramebuffer(GL_FRAMEBUFFER, g_motion_framebuffer[i]);
-		glViewport(0, 0, MAX_PLANETS, 1);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_motion_texture[i], 0);
+	unsigned int seed = g_options.have_seed ? g_options.seed : (unsigned int) time(NULL);
+	if (g_options.replay_file) {
+		assert_or_cleanup(open_replay(g_options.replay_file, &seed), "Failed to open replay file", NULL);
+	} else if (g_options.record_file) {
+		assert_or_cleanup(open_recording(g_options.record_file, seed), "Failed to open recording file", NULL);
+	}
+	my_srand(seed);
+
+	// Headless runs still use SDL for events and timers, which need no display
+	assert_or_cleanup(
+		SDL_Init(g_options.headless ? SDL_INIT_EVENTS | SDL_INIT_TIMER : SDL_INIT_VIDEO) == 0,
+		"Failed to init SDL subsystems",
+		SDL_GetError
+	);
+	push_cleanup_fn(SDL_Quit);
+
+	if (g_options.headless) {
+#ifdef HAVE_EGL
+		assert_or_cleanup(create_headless_context(3, 3), "Failed to create headless OpenGL context", egl_get_error_stringified);
+		g_glcontext = get_headless_context();
+#else
+		assert_or_cleanup(SDL_FALSE, "Headless mode is not available in this build", NULL);
+#endif
+	} else {
+#ifdef __EMSCRIPTEN__
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+#else
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+#endif
+		SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+		SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+
+		g_window = SDL_CreateWindow(
+			"Particle gravity",
+			SDL_WINDOWPOS_CENTERED,
+			SDL_WINDOWPOS_CENTERED,
+			WINDOW_W,
+			WINDOW_H,
+			SDL_WINDOW_OPENGL
+		);
+		assert_or_cleanup(g_window != NULL, "Failed to open window", SDL_GetError);
+		push_cleanup_fn(destroy_window);
+#ifndef DEBUG
+		register_message_window(g_window);
+#endif
+
+		g_glcontext = SDL_GL_CreateContext(g_window);
+		assert_or_cleanup(g_glcontext != NULL, "Failed to create OpenGL context", SDL_GetError);
+		push_cleanup_fn(delete_glcontext);
+	}
+
+#ifdef __EMSCRIPTEN__
+	const GLubyte *gl_version_str = glGetString(GL_VERSION);
+	write_log("%s\n", gl_version_str);
+	assert_or_cleanup(have_webgl_2((const char *) gl_version_str), "This browser does not support WebGL 2.0", gl_get_error_stringified);
+#else
+	GLADloadfunc get_proc_address = (GLADloadfunc) SDL_GL_GetProcAddress;
+#ifdef HAVE_EGL
+	if (g_options.headless) {
+		get_proc_address = (GLADloadfunc) headless_get_proc_address;
+	}
+#endif
+	int gl_version = gladLoadGL(get_proc_address);
+	assert_or_cleanup(gl_version != 0, "Failed to load OpenGL functions", NULL);
+	write_log("OpenGL version %d.%d\n", GLAD_VERSION_MAJOR(gl_version), GLAD_VERSION_MINOR(gl_version));
+
+	#ifdef DEBUG
+		if (!have_gl_debug_output(gl_version)) {
+			write_log("GL_DEBUG_OUTPUT unavailable\n");
+		} else {
+			write_log("Enabling GL_DEBUG_OUTPUT\n");
+			glEnable(GL_DEBUG_OUTPUT);
+			glDebugMessageCallback(gl_debug_message_callback, NULL);
+		}
+	#endif
+#endif
+
+	if (g_options.headless && g_options.offscreen) {
+		glGenRenderbuffers(1, &g_screen_renderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, g_screen_renderbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WINDOW_W, WINDOW_H);
+
+		glGenFramebuffers(1, &g_screen_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, g_screen_framebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_screen_renderbuffer);
 			assert_or_cleanup(
 				glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
-				"Planet position framebuffer incomplete",
+				"Offscreen framebuffer incomplete",
 				gl_get_error_stringified
 			);
-			glClearColor(0.0, 0.0, 0.0, 0.0);
-			glClear(GL_COLOR_BUFFER_BIT);
 	}
 
-	GLuint intersection_shaders[2]; // vertex, fragment
+	// Half floats blend on WebGL 2 as well, and are plenty for counting planets
+	glGenTextures(1, &g_splat_texture);
+	glBindTexture(GL_TEXTURE_2D, g_splat_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WINDOW_W / SPLAT_DOWNSCALE, WINDOW_H / SPLAT_DOWNSCALE, 0, GL_RGBA, GL_HALF_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &g_splat_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_splat_framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_splat_texture, 0);
+		assert_or_cleanup(
+			glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
+			"Density map framebuffer incomplete",
+			gl_get_error_stringified
+		);
+#ifndef __EMSCRIPTEN__
+	// Desktop GL ignores gl_PointSize otherwise; ES always honours it
+	glEnable(GL_PROGRAM_POINT_SIZE);
+#endif
 
-	intersection_shaders[0] = load_shader("shaders/quad.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(intersection_shaders[0] != 0, "Failed to load quad.vert", NULL);
+	// Reloading needs files to watch rather than the copies built in
+	if (g_options.watch_shaders && g_options.shader_dir == NULL) {
+		g_options.shader_dir = "shaders";
+	}
+	set_shader_dir(g_options.shader_dir);
+#ifdef HAVE_INOTIFY
+	if (g_options.watch_shaders && !watch_shader_dir(g_options.shader_dir)) {
+		write_log("Failed to watch %s; shaders won't reload\n", g_options.shader_dir);
+	}
+#else
+	if (g_options.watch_shaders) {
+		write_log("Shader reloading is not available in this build\n");
+	}
+#endif
+	if (g_options.program_cache && !init_program_cache()) {
+		write_log("Program binary cache unavailable\n");
+	}
+	if (g_options.autotune && !init_autotune(g_options.retune)) {
+		write_log("Autotuning results won't be saved\n");
+	}
 
-	intersection_shaders[1] = load_shader("shaders/resolve_intersections.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(intersection_shaders[1] != 0, "Failed to load resolve_intersections.frag", NULL);
+	glGenVertexArrays(1, &g_draw_vao);
+	glGenVertexArrays(1, &g_sprite_vao);
+	glGenVertexArrays(1, &g_splat_vao);
+	glBindVertexArray(g_draw_vao);
 
-	char *intersection_out = "out_impulse";
-	g_intersection_program = create_shader_program(2, intersection_shaders, 1, &intersection_out, 0, NULL);
-	assert_or_cleanup(g_intersection_program != 0, "Failed to link quad.vert and resolve_intersections.frag", gl_get_error_stringified);
+	g_frame_uniforms = (FrameUniforms) {
+		.planet_r = POINT_RADIUS,
+		.gravitational_constant = g_options.gravitational_constant,
+		.spring_k = g_options.spring_k,
+		.spring_b = g_options.spring_b,
+		.time_scale = g_options.time_scale,
+		.damping = g_options.damping,
+		.interpolation = 1.0,
+	};
 
-	glUseProgram(g_intersection_program);
-		glUniform1i(glGetUniformLocation(g_intersection_program, "positions"), POSITION_TEX_UNIT_OFFSET);
-		glUniform1f(glGetUniformLocation(g_intersection_program, "planet_r"), POINT_RADIUS);
+	glGenBuffers(1, &g_frame_ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, g_frame_ubo);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(g_frame_uniforms), &g_frame_uniforms, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, g_frame_ubo);
+
+	// Every pair of planets needs a texel, so the texture size limit caps the count
+	int startup_planets = g_options.num_planets;
+#ifndef __EMSCRIPTEN__
+	if (g_options.initial_state) {
+		assert_or_cleanup(read_snapshot(g_options.initial_state, &g_initial_state), "Failed to read initial state", NULL);
+		write_log("Starting from step %" PRIu64 " of %s\n", g_initial_state.step, g_options.initial_state);
+		startup_planets = g_initial_state.num_planets;
+	}
+#endif
+	g_max_planets = SDL_max(DEFAULT_MAX_PLANETS, startup_planets);
+	GLint max_texture_size;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	// Per-planet textures hold a planet a texel along one row, and the summed impulses
+	// one a texel down a column, so this holds for every backend; tiling bounds the
+	// pair matrix's memory, not its width
+	if (g_max_planets > max_texture_size) {
+		write_log("Asked for %d planets but the maximum texture size is %d, which limits every backend\n", g_max_planets, max_texture_size);
+		assert_or_cleanup(SDL_FALSE, "Too many planets for this GPU", NULL);
+	}
 
-	GLuint attraction_shaders[2]; // vertex, fragment
+	// Ensure buffers that won't immediately be overwritten are set to zero
+	GLuint *zeroes = my_malloc(2 * sizeof(GLuint) * g_max_planets);
+	assert_or_cleanup(zeroes != NULL, "Failed to allocate planet buffer", NULL);
+	for (int i = 0; i < 2 * g_max_planets; ++i) {
+		zeroes[i] = 0;
+	}
 
-	attraction_shaders[0] = load_shader("shaders/quad.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(attraction_shaders[0] != 0, "Failed to load quad.vert", NULL);
+	glGenBuffers(1, &g_circle_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, g_circle_vbo);
+		glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(float) * (CIRCLE_SIDES + 2), NULL, GL_STATIC_DRAW);
 
-	attraction_shaders[1] = load_shader("shaders/calc_particle_attractions.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(attraction_shaders[1] != 0, "Failed to load calc_particle_attractions.frag", NULL);
+	// Read with texelFetch() by draw and physics shaders alike, so filtering never applies
+	glGenTextures(1, &g_attribute_texture);
+	glBindTexture(GL_TEXTURE_2D, g_attribute_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, g_max_planets, 1, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, zeroes);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-	char *attraction_out = "out_attraction";
-	g_attraction_program = create_shader_program(2, attraction_shaders, 1, &attraction_out, 0, NULL);
-	assert_or_cleanup(g_attraction_program != 0, "Failed to link quad.vert and calc_particle_attractions.frag", gl_get_error_stringified);
+	my_free(zeroes);
 
-	glUseProgram(g_attraction_program);
-		glUniform1i(glGetUniformLocation(g_attraction_program, "positions"), POSITION_TEX_UNIT_OFFSET);
-		glUniform1f(glGetUniformLocation(g_attraction_program, "planet_r"), POINT_RADIUS);
+	g_gravity_enabled = g_options.gravity_enabled;
+	g_contacts_enabled = g_options.contacts_enabled;
+	if (g_options.sim_rate > 0 && !g_options.bench) {
+		g_sim_step_us = 1000000 / g_options.sim_rate;
+	}
+	g_paused = g_options.paused;
+	g_sim_idle = g_paused;
+	if (g_options.record_file || g_options.replay_file) {
+		// Window events aren't recorded, so hiding the window mustn't change the steps
+		g_options.background_throttle = SDL_FALSE;
+	}
+	g_requested_gravity = g_gravity_enabled;
+	g_requested_contacts = g_contacts_enabled;
+	g_pair_path = option_pair_path();
+	physics_defines(g_physics_defines, sizeof(g_physics_defines), g_gravity_enabled, g_contacts_enabled);
+	pair_defines(g_pair_defines, sizeof(g_pair_defines), g_gravity_enabled, g_contacts_enabled, g_pair_path.pair_block);
+	snprintf(g_fold_defines, sizeof(g_fold_defines), "#define FOLD_FACTOR %d\n", g_options.fold_factor);
+
+	// Compiles run while the textures below are allocated
+	init_parallel_shader_compile();
+	start_program_builds();
+
+	// Decided before finish_startup(), which sets up the draw programs to match
+#ifndef __EMSCRIPTEN__
+	if (g_options.culling) {
+		g_culling = init_culling();
+		if (!g_culling) {
+			write_log("GPU culling unavailable\n");
+		}
+	}
+#endif
+	if (!g_culling) {
+		GLint *bodies = my_malloc(sizeof(GLint) * g_max_planets);
+		assert_or_cleanup(bodies != NULL, "Failed to allocate planet buffer", NULL);
+		for (int i = 0; i < g_max_planets; ++i) {
+			bodies[i] = i;
+		}
+		glGenBuffers(1, &g_body_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, g_body_vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(GLint) * g_max_planets, bodies, GL_STATIC_DRAW);
+		my_free(bodies);
+	}
 
-	// n * n array of all planet pairs, with second for double-buffered summing
-	glGenTextures(2, g_impulse_texture);
-	glGenFramebuffers(2, g_impulse_framebuffer);
+	// Flat n * 1 texture of all planet positions
+	glGenTextures(2, g_motion_texture);
+	for (int i = 0; i < 2; ++i) {
+		glBindTexture(GL_TEXTURE_2D, g_motion_texture[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, g_max_planets, 1, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
 
+	// n * n array of all planet pairs, with second for double-buffered summing, or
+	// just a strip of rows of it where the whole would be too big. A fixed pair block
+	// narrows it to a column per block; autotuning may switch back to single pairs,
+	// so then it keeps a column per planet.
+	g_impulse_columns = g_options.autotune ? g_max_planets : (g_max_planets + g_options.pair_block - 1) / g_options.pair_block;
+	Uint64 matrix_mib = (Uint64) g_impulse_columns * g_max_planets * 2 * 2 * sizeof(GLfloat) >> 20;
+	int strip_rows = SDL_min(g_options.tile_rows, g_max_planets);
+	SDL_bool insist_matrix = g_options.backend == BACKEND_FRAGMENT && g_options.backend_given;
+	SDL_bool want_matrix = g_options.backend != BACKEND_TILED || g_options.autotune;
+	g_impulse_rows = want_matrix && (matrix_mib <= PAIR_MATRIX_BUDGET_MIB || insist_matrix) ? g_max_planets : strip_rows;
+	glGenTextures(2, g_impulse_texture);
 	for (int i = 0; i < 2; ++i) {
 		glBindTexture(GL_TEXTURE_2D, g_impulse_texture[i]);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, MAX_PLANETS, MAX_PLANETS, 0, GL_RG, GL_FLOAT, NULL);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, g_impulse_columns, g_impulse_rows, 0, GL_RG, GL_FLOAT, NULL);
+			if (glGetError() == GL_OUT_OF_MEMORY) {
+				assert_or_cleanup(g_impulse_rows > strip_rows, "Out of memory for attraction matrix", NULL);
+				// Start again with strips
+				g_impulse_rows = strip_rows;
+				i = -1;
+				continue;
+			}
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
+	if (g_impulse_rows < g_max_planets && g_options.backend == BACKEND_FRAGMENT) {
+		write_log(
+			"The pair matrix for %d planets needs %" PRIu64 " MiB; evaluating it in strips of %d rows\n",
+			g_max_planets,
+			matrix_mib,
+			strip_rows
+		);
+		g_options.backend = BACKEND_TILED;
+	}
 
+	// One impulse per planet, summed from the strips
+	glGenTextures(1, &g_impulse_sum_texture);
+	glBindTexture(GL_TEXTURE_2D, g_impulse_sum_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, 1, g_max_planets, 0, GL_RG, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	create_simulation_framebuffers();
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	for (int i = 0; i < 2; ++i) {
+		glBindFramebuffer(GL_FRAMEBUFFER, g_motion_framebuffer[i]);
+		glViewport(0, 0, g_max_planets, 1);
+			glClear(GL_COLOR_BUFFER_BIT);
 		glBindFramebuffer(GL_FRAMEBUFFER, g_impulse_framebuffer[i]);
-		glViewport(0, 0, MAX_PLANETS, MAX_PLANETS);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_impulse_texture[i], 0);
-			assert_or_cleanup(
-				glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
-				"Attraction matrix framebuffer incomplete",
-				gl_get_error_stringified
-			);
-			glClearColor(0.0, 0.0, 0.0, 0.0);
+		glViewport(0, 0, g_impulse_columns, g_impulse_rows);
 			glClear(GL_COLOR_BUFFER_BIT);
 	}
 
-	GLuint fold_shaders[2];
-
-	fold_shaders[0] = load_shader("shaders/quad.vert", GL_VERTEX_SHADER);
-	assert_or_cleanup(fold_shaders[0] != 0, "Failed to load quad.vert", NULL);
-
-	fold_shaders[1] = load_shader("shaders/fold_texture.frag", GL_FRAGMENT_SHADER);
-	assert_or_cleanup(fold_shaders[1] != 0, "Failed to load fold_texture.frag", NULL);
-
-	char *fold_out = "out_sum";
-	g_fold_program = create_shader_program(2, fold_shaders, 1, &fold_out, 0, NULL);
-	assert_or_cleanup(g_fold_program != 0, "Failed to link quad.vert and fold_texture.frag", gl_get_error_stringified);
-
-	glUseProgram(g_fold_program);
-		glUniform1i(glGetUniformLocation(g_fold_program, "inputs"), FOLD_TEX_UNIT_OFFSET);
+#ifndef __EMSCRIPTEN__
+	if (!wait_for_program_builds()) {
+		cleanup_and_quit(EXIT_SUCCESS);
+	}
+	finish_startup();
+
+	// Recordings and benchmarks need every step to line up with a frame
+	SDL_bool drawing = (!g_options.headless || g_options.offscreen) && g_options.batch_steps == 0;
+	if (g_options.sim_thread && drawing) {
+		if (g_options.record_file || g_options.replay_file || g_options.bench) {
+			write_log("Simulating on the main thread to keep steps in step with frames\n");
+		} else if (!start_sim_thread()) {
+			write_log("Shared GL contexts unavailable; simulating on the main thread\n");
+		}
+	}
+#endif
 
-	create_planet(0.0, 0.0, 0.0, 0.0, 0.0, 0.8, 0.2);
+	if (g_options.trace_file) {
+		assert_or_cleanup(init_trace(g_options.trace_file, g_options.trace_frames), "Failed to allocate trace buffer", NULL);
+	}
+	if ((g_options.gpu_timers || g_options.trace_file) && !init_gpu_timers(g_options.gpu_timers)) {
+		write_log("GPU timer queries unavailable\n");
+	}
+#ifdef DEBUG
+	init_input_latency(g_options.target_fps);
+#else
+	init_input_latency(0);
+#endif
 
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop(main_loop_emscripten, 0, EM_TRUE);
 #else
-	Uint64 f0_start = SDL_GetTicks64() - 1000 / FPS_CAP; // Last frame
-	Uint64 f1_start; // Current frame
-	Uint64 f1_end;
-	Uint64 f2_start; // Next frame
-
-#ifdef DEBUG
-	Uint64 frame_number = 0; // Which frame are we on
-	Uint64 recent_delays[FPS_CAP] = { 0 }; // Sliding window of frame times
-	for (int i = 0; i < FPS_CAP; ++i) {
-		recent_delays[i] = 1000 / FPS_CAP;
+	int target_fps = g_options.uncapped ? 0 : g_options.target_fps;
+	if (g_options.vsync && !g_options.uncapped) {
+		if (g_window && SDL_GL_SetSwapInterval(1) == 0) {
+			target_fps = 0;
+		} else {
+			write_log("Vsync unavailable, timing frames instead\n");
+		}
+	} else if (g_window) {
+		// Drivers may default to vsync, which would fight the pacer
+		SDL_GL_SetSwapInterval(0);
 	}
-	Uint64 recent_total = (1000 / FPS_CAP) * FPS_CAP; // Sum of array
+	FramePacer pacer;
+#ifdef DEBUG
+	init_frame_pacer(&pacer, target_fps, g_options.target_fps);
+	init_frame_fences(g_options.frames_in_flight, g_options.target_fps);
+#else
+	init_frame_pacer(&pacer, target_fps, 0);
+	init_frame_fences(g_options.frames_in_flight, 0);
 #endif
 
-	SDL_bool loop_done = SDL_FALSE;
+	if (g_options.batch_steps > 0) {
+		run_batch();
+		cleanup_and_quit(EXIT_SUCCESS);
+	}
 
+	SDL_bool loop_done = SDL_FALSE;
 	while (!loop_done) {
-		f1_start = SDL_GetTicks64();
-		f2_start = f1_start + 1000 / FPS_CAP;
-		loop_done = main_loop(f1_start - f0_start);
-		f1_end = SDL_GetTicks64();
-		f0_start = f1_start;
-#ifdef DEBUG
-		recent_total -= recent_delays[frame_number];
-		recent_delays[frame_number] = f1_end - f1_start;
-		recent_total += recent_delays[frame_number];
-		if (frame_number == 0) {
-			write_log("%2.2f FPS\n", (1000.0 * (float) FPS_CAP) / ((float) recent_total));
-		}
-		frame_number = (frame_number + 1) % FPS_CAP;
-#endif
-		if (f2_start > f1_end) {
-			SDL_Delay(f2_start - f1_end);
-		}
+		loop_done = main_loop(frame_pacer_begin_frame(&pacer));
+		trace_begin(TRACE_SLEEP);
+			frame_pacer_wait(&pacer);
+			if (simulation_idle()) {
+				// Nothing changes until something happens
+				SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+				frame_pacer_skip(&pacer);
+			}
+		trace_end(TRACE_SLEEP);
 	}
+	log_frame_pacer_stats(&pacer, "frames");
+	log_frame_fence_stats();
 #endif
 
+	if (g_options.bench) {
+		bench_report(backend_names[g_options.backend], g_num_planets, g_pair_path.fold_factor, g_pair_path.pair_block);
+	}
+	gpu_timer_flush();
+	write_trace();
+	log_input_latency();
+
 	cleanup_and_quit(EXIT_SUCCESS);
 	return EXIT_SUCCESS; // Unreachable but keeps compilers happy
 }
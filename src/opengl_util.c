@@ -1,6 +1,7 @@
 #include <stdio.h>
 
 #ifdef __EMSCRIPTEN__
+#include <emscripten/html5.h>
 #include <webgl/webgl2.h>
 #else
 #include "glad_gl.h"
@@ -9,6 +10,15 @@
 #include <SDL2/SDL.h>
 
 #include "util.h"
+#include "opengl_util.h"
+#include "program_cache.h"
+#include "shader_bundle.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static SDL_bool parallel_shader_compile = SDL_FALSE;
 
 // Returns: number of floats per pixel.
 int floats_per_pixel(GLenum format)
@@ -153,6 +163,77 @@ void format_screenshot_alloc(int x, int y, int width, int height, GLenum format,
 	my_free(buf);
 }
 
+// Returns: f as an IEEE half float, rounded to nearest even, for shaders to read with
+// unpackHalf2x16().
+GLushort float_to_half(GLfloat f)
+{
+	union { GLfloat f; Uint32 u; } bits = { f };
+	Uint32 sign = (bits.u >> 16) & 0x8000;
+	Uint32 magnitude = bits.u & 0x7FFFFFFF;
+
+	if (magnitude >= 0x7F800000) {
+		// Infinity stays infinity and NaN stays NaN
+		return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+	} else if (magnitude >= 0x477FF000) {
+		// Rounds past 65504, the largest half
+		return sign | 0x7C00;
+	} else if (magnitude < 0x38800000) {
+		// Below 2^-14 halves lose their implicit leading 1
+		Uint32 exponent = magnitude >> 23;
+		if (exponent < 102) {
+			return sign;
+		}
+		Uint32 mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+		Uint32 shift = 126 - exponent;
+		return sign | ((mantissa + (1 << (shift - 1))) >> shift);
+	}
+
+	// Rebias the exponent from 127 to 15; the rounding carry may bump it
+	return sign | ((magnitude - (112 << 23) + 0xFFF + ((magnitude >> 13) & 1)) >> 13);
+}
+
+// Returns: the IEEE half float h widened to a float, exactly.
+GLfloat half_to_float(GLushort h)
+{
+	Uint32 sign = (Uint32) (h & 0x8000) << 16;
+	Uint32 exponent = (h >> 10) & 0x1F;
+	Uint32 mantissa = h & 0x3FF;
+	union { Uint32 u; GLfloat f; } bits;
+
+	if (exponent == 0x1F) {
+		bits.u = sign | 0x7F800000 | (mantissa << 13);
+	} else if (exponent == 0) {
+		// Subnormal, or zero: the mantissa counts units of 2^-24
+		bits.f = mantissa / 16777216.0f;
+		bits.u |= sign;
+	} else {
+		bits.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	return bits.f;
+}
+
+// Packs four values in [0, 1] into bytes, first in the lowest, as GLSL's
+// packUnorm4x8() does.
+GLuint pack_unorm_4x8(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+	GLfloat values[4] = { x, y, z, w };
+	GLuint packed = 0;
+	for (int i = 0; i < 4; ++i) {
+		GLfloat clamped = SDL_max(0.0, SDL_min(1.0, values[i]));
+		packed |= (GLuint) (clamped * 255.0 + 0.5) << (8 * i);
+	}
+	return packed;
+}
+
+// Unpacks four bytes, first from the lowest, into values in [0, 1], as GLSL's
+// unpackUnorm4x8() does.
+void unpack_unorm_4x8(GLuint packed, GLfloat values[4])
+{
+	for (int i = 0; i < 4; ++i) {
+		values[i] = ((packed >> (8 * i)) & 0xFF) / 255.0f;
+	}
+}
+
 // Returns: if truthy, glEnable(GL_DEBUG_OUTPUT) and related functions can be called.
 SDL_bool have_gl_debug_output(int glad_gl_version)
 {
@@ -285,56 +366,46 @@ void print_program_log(GLuint program)
 	my_free(log_buffer);
 }
 
-// Loads a shader relative to the executable's location.
-// Returns: shader handle, or 0 on failure.
-GLuint load_shader(char *fname, GLenum shader_type)
+// Sets a shader's source, with defines (lines of "#define NAME VALUE", or NULL) and
+// then SHADER_PRELUDE placed straight after the #version line, where GLSL requires
+// them to go. A #line directive afterwards keeps line numbers in compile errors
+// matching the file.
+void shader_source_with_defines(GLuint shader, const GLchar *source, const char *defines)
 {
-	char full_path[256] = {0};
-	GLchar *buffer = NULL;
-
-	SDL_bool filepath_success = make_absolute_path(fname, full_path, 256);
-	if (!filepath_success) {
-		return 0;
-	}
-
-	// Open file
-	FILE *file = fopen(full_path, "r");
-	if (file == NULL) {
-		return 0;
-	}
-
-	// Determine size of shader source
-	int fseek_err = fseek(file, 0, SEEK_END); // TODO: fseeko(), ftello() safer
-	if (fseek_err != 0) {
-		fclose(file);
-		return 0;
+	const GLchar *version_end = strchr(source, '\n');
+	if (version_end == NULL || strncmp(source, "#version", 8) != 0) {
+		glShaderSource(shader, 1, &source, NULL);
+		return;
 	}
-	long fsize = ftell(file);
-	buffer = my_malloc(fsize + 1);
-	buffer[fsize] = 0;
-	rewind(file);
 
-	// Copy source into buffer
-	size_t bytes_read = fread(buffer, 1, fsize + 1, file);
-	if (ferror(file) != 0 || bytes_read != fsize || feof(file) == 0) {
-		my_free(buffer);
-		fclose(file);
-		return 0;
-	}
+	// GL copies the strings, so the prelude can be freed straight away
+	GLchar *prelude = read_shader_source(SHADER_PRELUDE);
+	const GLchar *strings[] = { source, defines ? defines : "", prelude ? prelude : "", "\n#line 2\n", version_end + 1 };
+	const GLint lengths[] = { version_end + 1 - source, -1, -1, -1, -1 };
+	glShaderSource(shader, 5, strings, lengths);
+	my_free(prelude);
+}
 
-	fclose(file);
+// Adds SHADER_PRELUDE to a program cache key, since every shader is built with it.
+void hash_shader_prelude(Uint64 *cache_key)
+{
+	GLchar *prelude = read_shader_source(SHADER_PRELUDE);
+	hash_string(cache_key, prelude ? prelude : "");
+	my_free(prelude);
+}
 
-	// Compile shader
+// Returns: shader handle, or 0 on failure.
+GLuint compile_shader(const GLchar *source, GLenum shader_type, const char *defines)
+{
 	GLuint shader = glCreateShader(shader_type);
-	glShaderSource(shader, 1, (const char * const *)&buffer, NULL);
+	shader_source_with_defines(shader, source, defines);
 	glCompileShader(shader);
 
-	my_free(buffer);
-
 	GLint compile_status;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
 	if (compile_status != GL_TRUE) {
 		print_shader_log(shader);
+		glDeleteShader(shader);
 		return 0;
 	}
 
@@ -342,13 +413,34 @@ GLuint load_shader(char *fname, GLenum shader_type)
 	return shader;
 }
 
-// Creates a program given a list of valid shader handles, out variables and transform
-// feedback variables. Detaches and deletes the shaders after linking.
-// Returns: program handle, or 0 on failure.
-GLuint create_shader_program(int num_shaders, GLuint *shaders, int num_outs, char **outs, int num_transforms, const char * const *transforms)
+// Loads a shader by file name, e.g. "quad.vert"; see read_shader_source(). Defines
+// are as for shader_source_with_defines().
+// Returns: shader handle, or 0 on failure.
+GLuint load_shader(char *fname, GLenum shader_type, const char *defines)
+{
+	GLchar *source = read_shader_source(fname);
+	if (source == NULL) {
+		return 0;
+	}
+
+	GLuint shader = compile_shader(source, shader_type, defines);
+	my_free(source);
+	return shader;
+}
+
+// Attaches shaders, sets out variables and transform feedback variables, and
+// submits the link without waiting for its result.
+// Returns: program handle.
+GLuint link_shader_program(int num_shaders, GLuint *shaders, int num_outs, char **outs, int num_transforms, const char * const *transforms)
 {
 	GLuint program = glCreateProgram();
 
+#ifndef __EMSCRIPTEN__
+	if (program_cache_enabled()) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+#endif
+
 	for (int i = 0; i < num_shaders; ++i) {
 		glAttachShader(program, shaders[i]);
 	}
@@ -368,26 +460,224 @@ GLuint create_shader_program(int num_shaders, GLuint *shaders, int num_outs, cha
 	}
 
 	glLinkProgram(program);
+	return program;
+}
 
-	for (int i = 0; i < num_shaders; ++i) {
-		glDetachShader(program, shaders[i]);
-		glDeleteShader(shaders[i]);
-	}
-
+// Waits for a link, and in debug builds validates the program. Validation depends
+// on state at the time and costs a round trip, so release builds skip it.
+// Returns: success.
+SDL_bool check_shader_program(GLuint program)
+{
 	GLint link_status;
 	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
 	if (link_status != GL_TRUE) {
 		print_program_log(program);
-		return 0;
+		return SDL_FALSE;
 	}
 
+#ifdef DEBUG
 	GLint validate_status;
 	glValidateProgram(program);
 	glGetProgramiv(program, GL_VALIDATE_STATUS, &validate_status);
 	if (validate_status != GL_TRUE) {
 		print_program_log(program);
+		return SDL_FALSE;
+	}
+#endif
+
+	return SDL_TRUE;
+}
+
+// Creates a program given a list of valid shader handles, out variables and transform
+// feedback variables. Detaches and deletes the shaders after linking.
+// Returns: program handle, or 0 on failure.
+GLuint create_shader_program(int num_shaders, GLuint *shaders, int num_outs, char **outs, int num_transforms, const char * const *transforms)
+{
+	GLuint program = link_shader_program(num_shaders, shaders, num_outs, outs, num_transforms, transforms);
+
+	for (int i = 0; i < num_shaders; ++i) {
+		glDetachShader(program, shaders[i]);
+		glDeleteShader(shaders[i]);
+	}
+
+	if (!check_shader_program(program)) {
+		glDeleteProgram(program);
 		return 0;
 	}
 
 	return program;
 }
+
+// Asks the driver to compile and link on its own threads, if it can. Call once,
+// before starting any program builds.
+void init_parallel_shader_compile(void)
+{
+#ifdef __EMSCRIPTEN__
+	parallel_shader_compile = emscripten_webgl_enable_extension(
+		emscripten_webgl_get_current_context(),
+		"KHR_parallel_shader_compile"
+	) ? SDL_TRUE : SDL_FALSE;
+#else
+	// 0xFFFFFFFF lets the driver choose how many threads to use
+	if (GLAD_GL_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		parallel_shader_compile = SDL_TRUE;
+	} else if (GLAD_GL_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		parallel_shader_compile = SDL_TRUE;
+	}
+#endif
+	if (!parallel_shader_compile) {
+		write_log("KHR_parallel_shader_compile unavailable\n");
+	}
+}
+
+// Starts building a program from a vertex and fragment shader, looked up as by
+// load_shader(), with the same defines in both. A program in the binary cache is
+// loaded straight away; otherwise the compiles and the link are submitted without
+// asking for any results, so that drivers can overlap them with each other and with
+// the caller's work.
+// Returns: success; on failure build is left empty.
+SDL_bool start_program_build(ProgramBuild *build, char *vert_fname, char *frag_fname, const char *defines, int num_outs, char **outs, int num_transforms, const char * const *transforms)
+{
+	*build = (ProgramBuild) { .vert_fname = vert_fname, .frag_fname = frag_fname };
+
+	GLchar *sources[2] = { read_shader_source(vert_fname), read_shader_source(frag_fname) };
+	if (sources[0] == NULL || sources[1] == NULL) {
+		write_log("Failed to read %s\n", sources[0] ? frag_fname : vert_fname);
+		my_free(sources[0]);
+		my_free(sources[1]);
+		return SDL_FALSE;
+	}
+
+	// Everything that feeds the link goes into the key, so that no edit is missed
+	build->cache_key = program_cache_key(2, (const char * const *) sources);
+	hash_string(&build->cache_key, defines ? defines : "");
+	hash_shader_prelude(&build->cache_key);
+	for (int i = 0; i < num_outs; ++i) {
+		hash_string(&build->cache_key, outs[i]);
+	}
+	for (int i = 0; i < num_transforms; ++i) {
+		hash_string(&build->cache_key, transforms[i]);
+	}
+
+	build->program = load_cached_program(build->cache_key);
+	if (build->program == 0) {
+		const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+		for (int i = 0; i < 2; ++i) {
+			build->shaders[i] = glCreateShader(types[i]);
+			shader_source_with_defines(build->shaders[i], sources[i], defines);
+			glCompileShader(build->shaders[i]);
+		}
+		build->program = link_shader_program(2, build->shaders, num_outs, outs, num_transforms, transforms);
+	}
+
+	my_free(sources[0]);
+	my_free(sources[1]);
+	return SDL_TRUE;
+}
+
+// Never blocks.
+// Returns: whether finish_program_build() can return without waiting.
+SDL_bool program_build_done(ProgramBuild *build)
+{
+	if (!parallel_shader_compile || build->shaders[0] == 0) {
+		return SDL_TRUE;
+	}
+
+	GLint done = GL_FALSE;
+	glGetProgramiv(build->program, GL_COMPLETION_STATUS_KHR, &done);
+	return done ? SDL_TRUE : SDL_FALSE;
+}
+
+// Waits for a build started by start_program_build(), logs any errors and saves the
+// result to the binary cache.
+// Returns: program handle, or 0 on failure.
+GLuint finish_program_build(ProgramBuild *build)
+{
+	GLuint program = build->program;
+	if (build->shaders[0] == 0) {
+		return program; // From the cache, or never started
+	}
+
+	SDL_bool success = check_shader_program(program);
+	for (int i = 0; i < 2; ++i) {
+		if (!success) {
+			// Compile errors only show up here, since nothing checked them earlier
+			GLint compile_status;
+			glGetShaderiv(build->shaders[i], GL_COMPILE_STATUS, &compile_status);
+			if (compile_status != GL_TRUE) {
+				write_log("Failed to compile %s\n", i == 0 ? build->vert_fname : build->frag_fname);
+				print_shader_log(build->shaders[i]);
+			}
+		}
+		glDetachShader(program, build->shaders[i]);
+		glDeleteShader(build->shaders[i]);
+		build->shaders[i] = 0;
+	}
+
+	if (!success) {
+		glDeleteProgram(program);
+		build->program = 0;
+		return 0;
+	}
+
+	save_cached_program(program, build->cache_key);
+	return program;
+}
+
+// Builds a program from a vertex and fragment shader, looked up as by load_shader(),
+// going through the program binary cache when it is available.
+// Returns: program handle, or 0 on failure.
+GLuint load_program(char *vert_fname, char *frag_fname, const char *defines, int num_outs, char **outs, int num_transforms, const char * const *transforms)
+{
+	ProgramBuild build;
+	if (!start_program_build(&build, vert_fname, frag_fname, defines, num_outs, outs, num_transforms, transforms)) {
+		return 0;
+	}
+	return finish_program_build(&build);
+}
+
+#ifndef __EMSCRIPTEN__
+// Builds a program from a single compute shader, looked up as by load_shader(),
+// going through the program binary cache when it is available. Check for compute
+// support first; WebGL has none.
+// Returns: program handle, or 0 on failure.
+GLuint load_compute_program(char *fname, const char *defines)
+{
+	GLchar *source = read_shader_source(fname);
+	if (source == NULL) {
+		write_log("Failed to read %s\n", fname);
+		return 0;
+	}
+	Uint64 cache_key = program_cache_key(1, (const char * const *) &source);
+	hash_string(&cache_key, defines ? defines : "");
+	hash_shader_prelude(&cache_key);
+
+	GLuint program = load_cached_program(cache_key);
+	if (program == 0) {
+		GLuint shader = compile_shader(source, GL_COMPUTE_SHADER, defines);
+		if (shader == 0) {
+			write_log("Failed to compile %s\n", fname);
+		} else {
+			program = create_shader_program(1, &shader, 0, NULL, 0, NULL);
+			if (program != 0) {
+				save_cached_program(program, cache_key);
+			}
+		}
+	}
+
+	my_free(source);
+	return program;
+}
+#endif
+
+// Points a program's uniform block at a buffer binding index. Programs whose shaders
+// don't declare the block are left alone.
+void bind_uniform_block(GLuint program, const char *block_name, GLuint binding)
+{
+	GLuint block_index = glGetUniformBlockIndex(program, block_name);
+	if (block_index != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, block_index, binding);
+	}
+}
@@ -1,17 +1,44 @@
 #ifndef OPENGL_UTIL_H
 #define OPENGL_UTIL_H
 
+#define SHADER_PRELUDE "frame.glsl" // Built into every shader, ahead of its own source
+
+// A program between start_program_build() and finish_program_build()
+typedef struct ProgramBuild {
+	GLuint program;
+	GLuint shaders[2]; // Vertex and fragment, or 0 if the program came from the cache
+	char *vert_fname;
+	char *frag_fname;
+	Uint64 cache_key;
+} ProgramBuild;
+
 int pixel_format_buffer_size(int x, int y, int width, int height, GLenum format, GLenum type);
-int pixel_read_buffer_size(int x, int y, int width, int height, GLenum format);
+int pixel_read_buffer_size(int x, int y, int width, int height, GLenum format, GLenum type);
 void format_screenshot(int x, int y, int width, int height, GLenum format, GLenum type, char *buf, int buflen, GLfloat *pixel_buf, int pixel_buflen);
 void format_screenshot_alloc(int x, int y, int width, int height, GLenum format, GLenum type);
+GLushort float_to_half(GLfloat f);
+GLfloat half_to_float(GLushort h);
+GLuint pack_unorm_4x8(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+void unpack_unorm_4x8(GLuint packed, GLfloat values[4]);
 SDL_bool have_gl_debug_output(int glad_gl_version);
 SDL_bool have_webgl_2(const char *gl_version_str);
 void gl_debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *user_param);
 const char *gl_get_error_stringified(void);
 void print_shader_log(GLuint shader);
 void print_program_log(GLuint program);
-GLuint load_shader(char *fname, GLenum shader_type);
+void shader_source_with_defines(GLuint shader, const GLchar *source, const char *defines);
+void hash_shader_prelude(Uint64 *cache_key);
+GLuint compile_shader(const GLchar *source, GLenum shader_type, const char *defines);
+GLuint load_shader(char *fname, GLenum shader_type, const char *defines);
+GLuint link_shader_program(int num_shaders, GLuint *shaders, int num_outs, char **outs, int num_transforms, const char * const *transforms);
+SDL_bool check_shader_program(GLuint program);
 GLuint create_shader_program(int num_shaders, GLuint *shaders, int num_outs, char **outs, int num_transforms, const char * const *transforms);
+void init_parallel_shader_compile(void);
+SDL_bool start_program_build(ProgramBuild *build, char *vert_fname, char *frag_fname, const char *defines, int num_outs, char **outs, int num_transforms, const char * const *transforms);
+SDL_bool program_build_done(ProgramBuild *build);
+GLuint finish_program_build(ProgramBuild *build);
+GLuint load_program(char *vert_fname, char *frag_fname, const char *defines, int num_outs, char **outs, int num_transforms, const char * const *transforms);
+GLuint load_compute_program(char *fname, const char *defines);
+void bind_uniform_block(GLuint program, const char *block_name, GLuint binding);
 
 #endif // OPENGL_UTIL_H
@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "options.h"
+#include "frame_fences.h"
+
+Options g_options = {
+	.record_file = NULL,
+	.replay_file = NULL,
+	.have_seed = SDL_FALSE,
+	.seed = 0,
+	.fixed_delta = 0,
+	.headless = SDL_FALSE,
+	.offscreen = SDL_FALSE,
+	.max_frames = 0,
+	.num_planets = 1,
+	.target_fps = 60,
+	.vsync = SDL_FALSE,
+	.uncapped = SDL_FALSE,
+	.frames_in_flight = 2,
+	.sim_thread = SDL_TRUE,
+	.sim_rate = 0,
+	.paused = SDL_FALSE,
+	.background_throttle = SDL_TRUE,
+	.bench = SDL_FALSE,
+	.batch_steps = 0,
+	.snapshot_every = 0,
+	.snapshot_prefix = "snapshot",
+	.initial_state = NULL,
+	.backend = BACKEND_FRAGMENT,
+	.backend_given = SDL_FALSE,
+	.autotune = SDL_TRUE,
+	.retune = SDL_FALSE,
+	.renderer = RENDERER_FAN,
+	.splat_threshold = 16384,
+	.culling = SDL_TRUE,
+#ifdef DEBUG
+	.gpu_timers = SDL_TRUE,
+#else
+	.gpu_timers = SDL_FALSE,
+#endif
+	.trace_file = NULL,
+	.trace_frames = 120,
+	.program_cache = SDL_TRUE,
+	.shader_dir = NULL,
+	.watch_shaders = SDL_FALSE,
+	.gravitational_constant = 0.01,
+	.spring_k = 2000.0,
+	.spring_b = 1000.0,
+	.time_scale = 0.01,
+	.damping = 0.995,
+	.gravity_enabled = SDL_TRUE,
+	.contacts_enabled = SDL_TRUE,
+	.fold_factor = 4,
+	.tile_rows = 256,
+	.pair_block = 1,
+};
+
+const char *backend_names[NUM_BACKENDS] = {
+	[BACKEND_FRAGMENT] = "fragment",
+	[BACKEND_TILED] = "tiled",
+};
+
+const char *renderer_names[NUM_RENDERERS] = {
+	[RENDERER_FAN] = "fan",
+	[RENDERER_SPRITE] = "sprite",
+	[RENDERER_SPLAT] = "splat",
+};
+
+// Logs the list of accepted command line options.
+void print_usage(char *program_name)
+{
+	write_log("Usage: %s [options]\n", program_name);
+	write_log("  --record FILE     log input events, RNG seed and frame times to FILE\n");
+	write_log("  --replay FILE     play back a file written by --record\n");
+	write_log("  --seed N          seed the RNG with N instead of the current time\n");
+	write_log("  --fixed-dt MS     advance the simulation by MS milliseconds every frame\n");
+	write_log("  --headless        run without a window or display (Linux only)\n");
+	write_log("  --offscreen       with --headless, still draw each frame to a framebuffer\n");
+	write_log("  --frames N        quit after N frames\n");
+	write_log("  --planets N       start with N bodies in random places\n");
+	write_log("  --fps N           hold the frame rate at N frames per second (default 60)\n");
+	write_log("  --vsync           wait for vertical sync instead of timing frames (not headless)\n");
+	write_log("  --uncapped        run as fast as possible instead of at the frame cap\n");
+	write_log("  --frames-in-flight N  let the CPU run up to N frames (1-3) ahead of the GPU:\n");
+	write_log("                    1 for the least input latency, 3 for throughput (default 2)\n");
+	write_log("  --no-sim-thread   step the simulation on the thread that draws\n");
+	write_log("  --sim-rate N      simulation steps per second, drawn interpolated (default --fps,\n");
+	write_log("                    or one step a frame on the drawing thread)\n");
+	write_log("  --paused          start paused (P to resume, N to single-step)\n");
+	write_log("  --no-background-throttle  keep simulating and drawing while the window is hidden\n");
+	write_log("  --bench           time every step and print a CSV row on exit\n");
+	write_log("  --batch S         simulate S steps as fast as possible without drawing, then print\n");
+	write_log("                    steps and pair interactions per second (default --fixed-dt 16)\n");
+	write_log("  --snapshot-every K  in a batch, write the planets to a file after every K steps\n");
+	write_log("  --snapshot-prefix PATH  name snapshots PATH-<step>.txt (default snapshot)\n");
+	write_log("  --initial-state FILE  start from a snapshot instead of random planets\n");
+	write_log("  --backend NAME    how to evaluate body pairs (see --list-backends; no autotuning)\n");
+	write_log("  --list-backends   print the available backends and exit\n");
+	write_log("  --no-autotune     use --backend and --fold-factor instead of the fastest measured\n");
+	write_log("  --retune          measure the pair paths again, replacing the saved results\n");
+	write_log("  --renderer NAME   draw planets as polygons (fan, default), anti-aliased quads (sprite)\n");
+	write_log("                    or a density map (splat)\n");
+	write_log("  --splat-threshold N  draw a density map above N planets (default 16384, 0 never)\n");
+	write_log("  --no-culling      draw every planet instead of culling off-screen ones on the GPU\n");
+	write_log("  --gpu-timers      log rolling per-pass GPU times (always on in debug builds)\n");
+	write_log("  --trace FILE      record a frame timeline; write it to FILE on F12 and on exit\n");
+	write_log("  --trace-frames N  how many of the latest frames a trace covers (default 120)\n");
+	write_log("  --no-program-cache  compile every shader, ignoring saved program binaries\n");
+	write_log("  --shader-dir DIR  read shaders from DIR instead of the copies built in\n");
+	write_log("  --watch-shaders   reload shaders when saved (Linux only; default --shader-dir shaders)\n");
+	write_log("  --gravity G       gravitational constant (default 0.01)\n");
+	write_log("  --spring-k K      stiffness of overlapping planets (default 2000)\n");
+	write_log("  --spring-b B      damping of overlapping planets (default 1000)\n");
+	write_log("  --time-scale S    multiplier from time step to acceleration (default 0.01)\n");
+	write_log("  --damping D       fraction of velocity kept each step (default 0.995)\n");
+	write_log("  --no-gravity      start with gravity compiled out (G toggles)\n");
+	write_log("  --no-contacts     start with collisions compiled out (C toggles)\n");
+	write_log("  --fold-factor N   columns summed by each pass of the gravity fold (default 4;\n");
+	write_log("                    no autotuning)\n");
+	write_log("  --tile-rows T     planets per strip with --backend tiled (default 256)\n");
+	write_log("  --pair-block B    partners summed by each fragment of the pair pass (1 to 32,\n");
+	write_log("                    default 1; no autotuning)\n");
+	write_log("  --help            show this message\n");
+}
+
+// Parses a non-negative integer, rejecting trailing garbage.
+// Returns: success.
+SDL_bool parse_unsigned(char *str, unsigned long long *out)
+{
+	char *end = NULL;
+	if (str == NULL || str[0] == '-') {
+		return SDL_FALSE;
+	}
+	*out = strtoull(str, &end, 10);
+	return end != str && *end == 0;
+}
+
+// Parses a finite floating-point number, rejecting trailing garbage.
+// Returns: success.
+SDL_bool parse_float(char *str, float *out)
+{
+	char *end = NULL;
+	if (str == NULL) {
+		return SDL_FALSE;
+	}
+	*out = strtof(str, &end);
+	return end != str && *end == 0 && isfinite(*out);
+}
+
+// Looks up a backend by the name it has in backend_names.
+// Returns: success.
+SDL_bool parse_backend(char *str, Backend *out)
+{
+	if (str == NULL) {
+		return SDL_FALSE;
+	}
+	for (int b = 0; b < NUM_BACKENDS; ++b) {
+		if (strcmp(str, backend_names[b]) == 0) {
+			*out = (Backend) b;
+			return SDL_TRUE;
+		}
+	}
+	return SDL_FALSE;
+}
+
+// Looks up a renderer by the name it has in renderer_names.
+// Returns: success.
+SDL_bool parse_renderer(char *str, Renderer *out)
+{
+	if (str == NULL) {
+		return SDL_FALSE;
+	}
+	for (int r = 0; r < NUM_RENDERERS; ++r) {
+		if (strcmp(str, renderer_names[r]) == 0) {
+			*out = (Renderer) r;
+			return SDL_TRUE;
+		}
+	}
+	return SDL_FALSE;
+}
+
+// Fills g_options from the command line. Logs usage on failure; exits straight away
+// for --help and --list-backends, since nothing has been set up yet.
+// Returns: success.
+SDL_bool parse_options(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; ++i) {
+		char *arg = argv[i];
+		char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		unsigned long long number;
+
+		if (strcmp(arg, "--help") == 0) {
+			print_usage(argv[0]);
+			exit(EXIT_SUCCESS);
+		} else if (strcmp(arg, "--record") == 0 && value) {
+			g_options.record_file = value;
+			++i;
+		} else if (strcmp(arg, "--replay") == 0 && value) {
+			g_options.replay_file = value;
+			++i;
+		} else if (strcmp(arg, "--seed") == 0 && parse_unsigned(value, &number)) {
+			g_options.have_seed = SDL_TRUE;
+			g_options.seed = (unsigned int) number;
+			++i;
+		} else if (strcmp(arg, "--fixed-dt") == 0 && parse_unsigned(value, &number) && number > 0) {
+			g_options.fixed_delta = number;
+			++i;
+		} else if (strcmp(arg, "--headless") == 0) {
+			g_options.headless = SDL_TRUE;
+		} else if (strcmp(arg, "--offscreen") == 0) {
+			g_options.offscreen = SDL_TRUE;
+		} else if (strcmp(arg, "--frames") == 0 && parse_unsigned(value, &number)) {
+			g_options.max_frames = number;
+			++i;
+		} else if (strcmp(arg, "--planets") == 0 && parse_unsigned(value, &number) && number > 0 && number <= INT_MAX) {
+			g_options.num_planets = (int) number;
+			++i;
+		} else if (strcmp(arg, "--fps") == 0 && parse_unsigned(value, &number) && number > 0 && number <= 1000) {
+			g_options.target_fps = (int) number;
+			++i;
+		} else if (strcmp(arg, "--vsync") == 0) {
+			g_options.vsync = SDL_TRUE;
+		} else if (strcmp(arg, "--uncapped") == 0) {
+			g_options.uncapped = SDL_TRUE;
+		} else if (strcmp(arg, "--frames-in-flight") == 0 && parse_unsigned(value, &number) && number > 0 && number <= MAX_FRAMES_IN_FLIGHT) {
+			g_options.frames_in_flight = (int) number;
+			++i;
+		} else if (strcmp(arg, "--no-sim-thread") == 0) {
+			g_options.sim_thread = SDL_FALSE;
+		} else if (strcmp(arg, "--sim-rate") == 0 && parse_unsigned(value, &number) && number > 0 && number <= 1000) {
+			g_options.sim_rate = (int) number;
+			++i;
+		} else if (strcmp(arg, "--paused") == 0) {
+			g_options.paused = SDL_TRUE;
+		} else if (strcmp(arg, "--no-background-throttle") == 0) {
+			g_options.background_throttle = SDL_FALSE;
+		} else if (strcmp(arg, "--bench") == 0) {
+			g_options.bench = SDL_TRUE;
+			g_options.uncapped = SDL_TRUE;
+		} else if (strcmp(arg, "--batch") == 0 && parse_unsigned(value, &number) && number > 0) {
+			g_options.batch_steps = number;
+			++i;
+		} else if (strcmp(arg, "--snapshot-every") == 0 && parse_unsigned(value, &number) && number > 0) {
+			g_options.snapshot_every = number;
+			++i;
+		} else if (strcmp(arg, "--snapshot-prefix") == 0 && value) {
+			g_options.snapshot_prefix = value;
+			++i;
+		} else if (strcmp(arg, "--initial-state") == 0 && value) {
+			g_options.initial_state = value;
+			++i;
+		} else if (strcmp(arg, "--backend") == 0 && parse_backend(value, &g_options.backend)) {
+			g_options.backend_given = SDL_TRUE;
+			g_options.autotune = SDL_FALSE;
+			++i;
+		} else if (strcmp(arg, "--no-autotune") == 0) {
+			g_options.autotune = SDL_FALSE;
+		} else if (strcmp(arg, "--retune") == 0) {
+			g_options.retune = SDL_TRUE;
+		} else if (strcmp(arg, "--renderer") == 0 && parse_renderer(value, &g_options.renderer)) {
+			++i;
+		} else if (strcmp(arg, "--splat-threshold") == 0 && parse_unsigned(value, &number) && number <= INT_MAX) {
+			g_options.splat_threshold = (int) number;
+			++i;
+		} else if (strcmp(arg, "--no-culling") == 0) {
+			g_options.culling = SDL_FALSE;
+		} else if (strcmp(arg, "--gpu-timers") == 0) {
+			g_options.gpu_timers = SDL_TRUE;
+		} else if (strcmp(arg, "--trace") == 0 && value) {
+			g_options.trace_file = value;
+			++i;
+		} else if (strcmp(arg, "--trace-frames") == 0 && parse_unsigned(value, &number) && number > 0 && number <= 100000) {
+			g_options.trace_frames = (int) number;
+			++i;
+		} else if (strcmp(arg, "--no-program-cache") == 0) {
+			g_options.program_cache = SDL_FALSE;
+		} else if (strcmp(arg, "--shader-dir") == 0 && value) {
+			g_options.shader_dir = value;
+			++i;
+		} else if (strcmp(arg, "--watch-shaders") == 0) {
+			g_options.watch_shaders = SDL_TRUE;
+		} else if (strcmp(arg, "--gravity") == 0 && parse_float(value, &g_options.gravitational_constant)) {
+			++i;
+		} else if (strcmp(arg, "--spring-k") == 0 && parse_float(value, &g_options.spring_k)) {
+			++i;
+		} else if (strcmp(arg, "--spring-b") == 0 && parse_float(value, &g_options.spring_b)) {
+			++i;
+		} else if (strcmp(arg, "--time-scale") == 0 && parse_float(value, &g_options.time_scale)) {
+			++i;
+		} else if (strcmp(arg, "--damping") == 0 && parse_float(value, &g_options.damping)) {
+			++i;
+		} else if (strcmp(arg, "--no-gravity") == 0) {
+			g_options.gravity_enabled = SDL_FALSE;
+		} else if (strcmp(arg, "--no-contacts") == 0) {
+			g_options.contacts_enabled = SDL_FALSE;
+		} else if (strcmp(arg, "--fold-factor") == 0 && parse_unsigned(value, &number) && number >= 2 && number <= 64) {
+			g_options.fold_factor = (int) number;
+			g_options.autotune = SDL_FALSE;
+			++i;
+		} else if (strcmp(arg, "--pair-block") == 0 && parse_unsigned(value, &number) && number > 0 && number <= 32) {
+			// The shader unrolls its loop over the block, so keep that short
+			g_options.pair_block = (int) number;
+			g_options.autotune = SDL_FALSE;
+			++i;
+		} else if (strcmp(arg, "--tile-rows") == 0 && parse_unsigned(value, &number) && number > 0 && number <= INT_MAX) {
+			g_options.tile_rows = (int) number;
+			++i;
+		} else if (strcmp(arg, "--list-backends") == 0) {
+			// Printed rather than logged: scripts read this
+			for (int b = 0; b < NUM_BACKENDS; ++b) {
+				printf("%s\n", backend_names[b]);
+			}
+			exit(EXIT_SUCCESS);
+		} else {
+			write_log("Unrecognised or incomplete option: %s\n", arg);
+			print_usage(argv[0]);
+			return SDL_FALSE;
+		}
+	}
+
+	if (g_options.record_file && g_options.replay_file) {
+		write_log("--record and --replay cannot be used together\n");
+		return SDL_FALSE;
+	}
+	if (g_options.batch_steps > 0 && (g_options.record_file || g_options.replay_file || g_options.bench)) {
+		write_log("--batch cannot be used with --record, --replay or --bench\n");
+		return SDL_FALSE;
+	}
+	if (g_options.snapshot_every > 0 && g_options.batch_steps == 0) {
+		write_log("--snapshot-every needs --batch\n");
+		return SDL_FALSE;
+	}
+	if (g_options.record_file || g_options.replay_file || g_options.bench || g_options.batch_steps > 0) {
+		// Paths sum in different orders, so replays and batches only match on a fixed
+		// one, and benchmarks time the one they name
+		g_options.autotune = SDL_FALSE;
+	}
+	if (g_options.batch_steps > 0 && g_options.fixed_delta == 0) {
+		// Wall-clock steps would make the results depend on how fast the batch ran
+		g_options.fixed_delta = 16;
+	}
+
+	return SDL_TRUE;
+}
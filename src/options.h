@@ -0,0 +1,79 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Ways of evaluating the all-pairs passes. Keep in step with backend_names.
+typedef enum Backend {
+	BACKEND_FRAGMENT, // One fragment per pair, folded down by fold_texture.frag
+	BACKEND_TILED, // The same, a strip of rows at a time, to bound memory
+	NUM_BACKENDS,
+} Backend;
+
+// Ways of drawing the planets. Keep in step with renderer_names.
+typedef enum Renderer {
+	RENDERER_FAN, // Instanced triangle fans from init_circle.vert
+	RENDERER_SPRITE, // One quad per planet, cut into a disc in particles.frag
+	RENDERER_SPLAT, // Points summed into a low-resolution density texture
+	NUM_RENDERERS,
+} Renderer;
+
+typedef struct Options {
+	char *record_file; // Log input events and frame times to this file
+	char *replay_file; // Play back a file written with record_file
+	SDL_bool have_seed;
+	unsigned int seed;
+	Uint64 fixed_delta; // Milliseconds per frame, or 0 to use wall-clock time
+	SDL_bool headless; // No window: render nothing, or to an offscreen framebuffer
+	SDL_bool offscreen; // Keep drawing when headless
+	Uint64 max_frames; // Quit after this many frames, or 0 to run until told to quit
+	int num_planets; // Bodies to spawn at startup, including the one at the origin
+	int target_fps; // Frame rate the main loop is paced to
+	SDL_bool vsync; // Let buffer swaps pace the main loop instead of target_fps
+	SDL_bool uncapped; // Don't pace the main loop at all
+	int frames_in_flight; // Frames the CPU may submit before the GPU finishes them
+	SDL_bool sim_thread; // Step the simulation on its own thread and GL context
+	int sim_rate; // Steps per second on that thread, or 0 for target_fps
+	SDL_bool paused; // Start with the simulation paused
+	SDL_bool background_throttle; // Go idle while the window is hidden
+	SDL_bool bench; // Time every step and print a CSV row on exit
+	Uint64 batch_steps; // Simulate this many steps without drawing, then quit, or 0
+	Uint64 snapshot_every; // In a batch, write the planets out after every this many steps
+	char *snapshot_prefix; // Snapshots go to <prefix>-<step>.txt
+	char *initial_state; // Start from a snapshot instead of random planets
+	Backend backend;
+	SDL_bool backend_given; // Chosen on the command line, so used even past memory limits
+	SDL_bool autotune; // Time the pair paths per planet count and use the fastest
+	SDL_bool retune; // Measure again instead of using results saved by earlier runs
+	Renderer renderer;
+	int splat_threshold; // Use RENDERER_SPLAT above this many planets, or 0 to never
+	SDL_bool culling; // Skip drawing off-screen planets, where the GPU can do it alone
+	SDL_bool gpu_timers; // Log per-pass GPU times
+	char *trace_file; // Chrome trace written on F12 and on exit
+	int trace_frames; // How many of the most recent frames a trace covers
+	SDL_bool program_cache; // Save linked programs and reuse them on later runs
+	char *shader_dir; // Read shaders from files here, not from the executable
+	SDL_bool watch_shaders; // Rebuild programs when their files in shader_dir change
+	// Physics constants, passed to the shaders through the Frame uniform block
+	float gravitational_constant;
+	float spring_k; // Intersection displacement multiplier
+	float spring_b; // Intersection velocity multiplier
+	float time_scale;
+	float damping; // Fraction of velocity kept each step
+	// Which physics to compile into the shaders at startup. G and C switch to another
+	// build of them, compiled the first time it's needed
+	SDL_bool gravity_enabled;
+	SDL_bool contacts_enabled;
+	int fold_factor; // Columns summed per fold pass, unless autotuning picks
+	int tile_rows; // Rows of the pair matrix evaluated at a time by BACKEND_TILED
+	int pair_block; // Partners summed by each fragment of the pair pass, unless autotuning picks
+} Options;
+
+extern Options g_options;
+
+extern const char *backend_names[NUM_BACKENDS];
+extern const char *renderer_names[NUM_RENDERERS];
+
+void print_usage(char *program_name);
+SDL_bool parse_backend(char *str, Backend *out);
+SDL_bool parse_options(int argc, char *argv[]);
+
+#endif // OPTIONS_H
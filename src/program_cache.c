@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "program_cache.h"
+
+// Linked program binaries saved with glGetProgramBinary(), so that later runs can
+// skip compiling and linking entirely. Files are keyed by a hash of everything that
+// goes into a program, including the driver's identity, since a binary is only valid
+// for the driver that produced it. WebGL has no program binaries.
+
+#define PROGRAM_CACHE_MAGIC 0x42504c50 // "PLPB"
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static SDL_bool cache_enabled = SDL_FALSE;
+static char *cache_dir = NULL;
+static Uint64 driver_hash = FNV_OFFSET_BASIS;
+static int cache_hits = 0;
+static int cache_misses = 0;
+
+// Frees the directory name allocated by init_program_cache().
+void free_program_cache(void)
+{
+	SDL_free(cache_dir);
+	cache_dir = NULL;
+	cache_enabled = SDL_FALSE;
+}
+
+// Must be called with a current context. Until it succeeds, nothing is cached.
+// Returns: whether the cache is usable.
+SDL_bool init_program_cache(void)
+{
+#ifdef __EMSCRIPTEN__
+	return SDL_FALSE;
+#else
+	if (!GLAD_GL_ARB_get_program_binary) {
+		return SDL_FALSE;
+	}
+	GLint num_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	if (num_formats == 0) {
+		return SDL_FALSE;
+	}
+
+	cache_dir = SDL_GetPrefPath("Cuttleshock", "planetarium");
+	if (cache_dir == NULL) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(free_program_cache);
+
+	const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	for (int i = 0; i < sizeof(driver_strings) / sizeof(driver_strings[0]); ++i) {
+		const char *str = (const char *) glGetString(driver_strings[i]);
+		hash_string(&driver_hash, str ? str : "");
+	}
+
+	cache_enabled = SDL_TRUE;
+	return SDL_TRUE;
+#endif
+}
+
+// Returns: whether init_program_cache() succeeded.
+SDL_bool program_cache_enabled(void)
+{
+	return cache_enabled;
+}
+
+// Mixes a string, including its terminator, into an FNV-1a hash.
+void hash_string(Uint64 *hash, const char *str)
+{
+	do {
+		*hash ^= (unsigned char) *str;
+		*hash *= FNV_PRIME;
+	} while (*str++);
+}
+
+// Returns: cache key for a program built from these strings (sources, defines,
+// output and transform feedback names, in a fixed order) on the current driver.
+Uint64 program_cache_key(int num_strings, const char * const *strings)
+{
+	Uint64 hash = driver_hash;
+	for (int i = 0; i < num_strings; ++i) {
+		hash_string(&hash, strings[i] ? strings[i] : "");
+	}
+	return hash;
+}
+
+// Writes the cache file name for a key to buf.
+// Returns: success.
+SDL_bool program_cache_path(Uint64 key, char *buf, size_t bufsiz)
+{
+	int len = snprintf(buf, bufsiz, "%sprogram-%016" PRIx64 ".bin", cache_dir, key);
+	return len > 0 && len < bufsiz;
+}
+
+// Creates a program from a cached binary.
+// Returns: linked program handle, or 0 if there was no usable binary.
+GLuint load_cached_program(Uint64 key)
+{
+	GLuint program = 0;
+#ifndef __EMSCRIPTEN__
+	char path[1024];
+	if (!cache_enabled || !program_cache_path(key, path, sizeof(path))) {
+		return 0;
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		++cache_misses;
+		return 0;
+	}
+
+	Uint32 header[3]; // Magic, binary format, length
+	void *binary = NULL;
+	if (fread(header, sizeof(header), 1, file) == 1 && header[0] == PROGRAM_CACHE_MAGIC) {
+		binary = my_malloc(header[2]);
+		if (binary && fread(binary, 1, header[2], file) == header[2]) {
+			program = glCreateProgram();
+			glProgramBinary(program, header[1], binary, header[2]);
+
+			// Drivers reject binaries from other versions, even with a matching key
+			GLint link_status;
+			glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+			if (link_status != GL_TRUE) {
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+		my_free(binary);
+	}
+	fclose(file);
+
+	if (program) {
+		++cache_hits;
+	} else {
+		++cache_misses;
+	}
+#endif
+	return program;
+}
+
+// Saves a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT, for
+// load_cached_program() to find next time. Failures only cost the next startup.
+void save_cached_program(GLuint program, Uint64 key)
+{
+#ifndef __EMSCRIPTEN__
+	char path[1024];
+	if (!cache_enabled || !program_cache_path(key, path, sizeof(path))) {
+		return;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	void *binary = my_malloc(length);
+	if (binary == NULL) {
+		return;
+	}
+	GLenum format;
+	glGetProgramBinary(program, length, &length, &format, binary);
+
+	// Written under another name and renamed into place, so a failed write never
+	// leaves a truncated file where the next run would look
+	char temp_path[sizeof(path) + 4];
+	snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+	FILE *file = fopen(temp_path, "wb");
+	if (file) {
+		Uint32 header[3] = { PROGRAM_CACHE_MAGIC, format, length };
+		SDL_bool ok = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(binary, 1, length, file) == length;
+		ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+		// rename() won't replace an existing file here
+		remove(path);
+#endif
+		if (!ok || rename(temp_path, path) != 0) {
+			write_log("Failed to write program cache file %s\n", path);
+			remove(temp_path);
+		}
+	}
+	my_free(binary);
+#endif
+}
+
+// Logs how many programs were loaded from the cache so far.
+void log_program_cache_stats(void)
+{
+	if (cache_enabled) {
+		write_log("Program cache: %d hits, %d misses\n", cache_hits, cache_misses);
+	}
+}
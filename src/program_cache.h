@@ -0,0 +1,12 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+SDL_bool init_program_cache(void);
+SDL_bool program_cache_enabled(void);
+void hash_string(Uint64 *hash, const char *str);
+Uint64 program_cache_key(int num_strings, const char * const *strings);
+GLuint load_cached_program(Uint64 key);
+void save_cached_program(GLuint program, Uint64 key);
+void log_program_cache_stats(void);
+
+#endif // PROGRAM_CACHE_H
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "replay.h"
+
+// Plain-text format, one record per line:
+// 	planetarium-replay 2
+// 	seed <seed>
+// 	f <frame> <delta us>
+// 	e <frame> quit
+// 	e <frame> key <scancode>
+// 	e <frame> down|up <button> <x> <y>
+// 	e <frame> motion <x> <y> <xrel> <yrel>
+// Every frame has exactly one "f" line, followed by the events polled during it.
+// Version 1 files, which are still played back, have frame times in milliseconds.
+
+#define REPLAY_MAGIC "planetarium-replay "
+#define REPLAY_VERSION 2
+
+typedef enum ReplayMode {
+	REPLAY_OFF,
+	REPLAY_RECORDING,
+	REPLAY_PLAYING,
+} ReplayMode;
+
+static ReplayMode replay_mode = REPLAY_OFF;
+static FILE *replay_file = NULL;
+static Uint64 replay_frame = 0; // Frame currently being recorded or played
+static SDL_bool replay_started = SDL_FALSE; // Has replay_frame_delta() been called yet?
+static SDL_bool replay_finished = SDL_FALSE;
+static char replay_line[128]; // Lookahead when playing
+static SDL_bool replay_have_line = SDL_FALSE;
+static Uint64 replay_delta_scale = 1; // Microseconds per unit of recorded frame time
+
+// Closes file opened by open_recording() or open_replay().
+void close_replay(void)
+{
+	if (replay_mode == REPLAY_PLAYING) {
+		write_log("Replay stopped after %" PRIu64 " frames\n", replay_frame);
+	}
+	if (replay_file) {
+		if (fclose(replay_file) != 0) {
+			write_log("Failed to close replay file\n");
+		}
+		replay_file = NULL;
+	}
+	replay_mode = REPLAY_OFF;
+}
+
+// Starts logging input to a new file.
+// Returns: success.
+SDL_bool open_recording(char *fname, unsigned int seed)
+{
+	replay_file = fopen(fname, "w");
+	if (replay_file == NULL) {
+		return SDL_FALSE;
+	}
+
+	fprintf(replay_file, REPLAY_MAGIC "%d\nseed %u\n", REPLAY_VERSION, seed);
+	replay_mode = REPLAY_RECORDING;
+	push_cleanup_fn(close_replay);
+	write_log("Recording input to %s\n", fname);
+	return SDL_TRUE;
+}
+
+// Reads the next line of a replay into the lookahead buffer.
+// Returns: whether there was a line to read.
+SDL_bool read_replay_line(void)
+{
+	if (!replay_have_line) {
+		replay_have_line = fgets(replay_line, sizeof(replay_line), replay_file) != NULL;
+	}
+	return replay_have_line;
+}
+
+// Opens a file written by open_recording() for playback.
+// Returns: success; seed is set to the seed the recording was made with.
+SDL_bool open_replay(char *fname, unsigned int *seed)
+{
+	replay_file = fopen(fname, "r");
+	if (replay_file == NULL) {
+		return SDL_FALSE;
+	}
+
+	int version = 0;
+	if (fscanf(replay_file, REPLAY_MAGIC "%d", &version) != 1
+		|| version < 1
+		|| version > REPLAY_VERSION
+		|| fscanf(replay_file, " seed %u ", seed) != 1
+	) {
+		fclose(replay_file);
+		replay_file = NULL;
+		return SDL_FALSE;
+	}
+
+	replay_delta_scale = version == 1 ? 1000 : 1;
+	replay_mode = REPLAY_PLAYING;
+	push_cleanup_fn(close_replay);
+	write_log("Playing back input from %s with seed %u\n", fname, *seed);
+	return SDL_TRUE;
+}
+
+// Advances to the next frame. Call once per frame, before polling any events.
+// Returns: the time step to simulate in microseconds, which when playing comes from
+// the file rather than from live_delta.
+Uint64 replay_frame_delta(Uint64 live_delta)
+{
+	if (replay_started) {
+		++replay_frame;
+	}
+	replay_started = SDL_TRUE;
+
+	switch (replay_mode) {
+		case REPLAY_RECORDING:
+			fprintf(replay_file, "f %" PRIu64 " %" PRIu64 "\n", replay_frame, live_delta);
+			return live_delta;
+		case REPLAY_PLAYING: {
+			Uint64 frame;
+			Uint64 delta;
+			if (read_replay_line()
+				&& sscanf(replay_line, "f %" SCNu64 " %" SCNu64, &frame, &delta) == 2
+				&& frame == replay_frame
+			) {
+				replay_have_line = SDL_FALSE;
+				return delta * replay_delta_scale;
+			}
+			// Out of frames (or out of sync): leave the next poll to end the program
+			replay_finished = SDL_TRUE;
+			return 0;
+		}
+		default:
+			return live_delta;
+	}
+}
+
+// Writes an event to the recording, if it is one that affects the simulation.
+void record_event(SDL_Event *e)
+{
+	switch (e->type) {
+		case SDL_QUIT:
+			fprintf(replay_file, "e %" PRIu64 " quit\n", replay_frame);
+			break;
+		case SDL_KEYDOWN:
+			fprintf(replay_file, "e %" PRIu64 " key %d\n", replay_frame, e->key.keysym.scancode);
+			break;
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+			fprintf(
+				replay_file,
+				"e %" PRIu64 " %s %d %d %d\n",
+				replay_frame,
+				e->type == SDL_MOUSEBUTTONDOWN ? "down" : "up",
+				e->button.button,
+				e->button.x,
+				e->button.y
+			);
+			break;
+		case SDL_MOUSEMOTION:
+			fprintf(
+				replay_file,
+				"e %" PRIu64 " motion %d %d %d %d\n",
+				replay_frame,
+				e->motion.x,
+				e->motion.y,
+				e->motion.xrel,
+				e->motion.yrel
+			);
+			break;
+		default:
+			break;
+	}
+}
+
+// Fills e from the next recorded event of the current frame.
+// Returns: whether there was one.
+SDL_bool read_recorded_event(SDL_Event *e)
+{
+	if (replay_finished) {
+		// Reporting quit once is enough for update() to end the main loop
+		replay_finished = SDL_FALSE;
+		memset(e, 0, sizeof(*e));
+		e->type = SDL_QUIT;
+		return SDL_TRUE;
+	}
+
+	Uint64 frame;
+	char kind[16];
+	int offset = 0;
+	if (!read_replay_line()
+		|| sscanf(replay_line, "e %" SCNu64 " %15s %n", &frame, kind, &offset) != 2
+		|| frame != replay_frame
+	) {
+		return SDL_FALSE;
+	}
+	replay_have_line = SDL_FALSE;
+
+	char *args = replay_line + offset;
+	int button, a, b, c, d;
+	memset(e, 0, sizeof(*e));
+
+	if (strcmp(kind, "quit") == 0) {
+		e->type = SDL_QUIT;
+	} else if (strcmp(kind, "key") == 0 && sscanf(args, "%d", &a) == 1) {
+		e->type = SDL_KEYDOWN;
+		e->key.state = SDL_PRESSED;
+		e->key.keysym.scancode = (SDL_Scancode) a;
+	} else if ((strcmp(kind, "down") == 0 || strcmp(kind, "up") == 0) && sscanf(args, "%d %d %d", &button, &a, &b) == 3) {
+		e->type = kind[0] == 'd' ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+		e->button.state = kind[0] == 'd' ? SDL_PRESSED : SDL_RELEASED;
+		e->button.button = button;
+		e->button.x = a;
+		e->button.y = b;
+	} else if (strcmp(kind, "motion") == 0 && sscanf(args, "%d %d %d %d", &a, &b, &c, &d) == 4) {
+		e->type = SDL_MOUSEMOTION;
+		e->motion.x = a;
+		e->motion.y = b;
+		e->motion.xrel = c;
+		e->motion.yrel = d;
+	} else {
+		write_log("Skipping unreadable replay line: %s", replay_line);
+		return read_recorded_event(e);
+	}
+
+	return SDL_TRUE;
+}
+
+// Drop-in replacement for SDL_PollEvent() that records or plays back input.
+// While playing, live input is discarded except for requests to quit.
+// Returns: whether e was filled.
+SDL_bool poll_input_event(SDL_Event *e)
+{
+	switch (replay_mode) {
+		case REPLAY_RECORDING:
+			if (SDL_PollEvent(e)) {
+				record_event(e);
+				return SDL_TRUE;
+			}
+			return SDL_FALSE;
+		case REPLAY_PLAYING:
+			while (SDL_PollEvent(e)) {
+				if (e->type == SDL_QUIT) {
+					return SDL_TRUE;
+				}
+			}
+			return read_recorded_event(e);
+		default:
+			return SDL_PollEvent(e) ? SDL_TRUE : SDL_FALSE;
+	}
+}
@@ -0,0 +1,9 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+SDL_bool open_recording(char *fname, unsigned int seed);
+SDL_bool open_replay(char *fname, unsigned int *seed);
+Uint64 replay_frame_delta(Uint64 live_delta);
+SDL_bool poll_input_event(SDL_Event *e);
+
+#endif // REPLAY_H
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "shader_bundle.h"
+
+// Shader sources normally come from the table the build embeds in the executable,
+// so nothing is read from disk at startup. For working on shaders, set_shader_dir()
+// switches to reading the files instead, with no rebuild needed after an edit.
+
+static char *shader_dir = NULL;
+
+// Reads shaders from files in dir from now on, or from the bundle if dir is NULL.
+void set_shader_dir(char *dir)
+{
+	shader_dir = dir;
+	if (dir) {
+		write_log("Reading shaders from %s\n", dir);
+	}
+}
+
+int compare_bundle_entry(const void *name, const void *entry)
+{
+	return strcmp(name, ((const ShaderBundleEntry *) entry)->name);
+}
+
+// Returns: contents of a text file, NUL terminated, or NULL on failure.
+char *read_text_file(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	// Determine size of shader source
+	int fseek_err = fseek(file, 0, SEEK_END); // TODO: fseeko(), ftello() safer
+	if (fseek_err != 0) {
+		fclose(file);
+		return NULL;
+	}
+	long fsize = ftell(file);
+	char *buffer = my_malloc(fsize + 1);
+	buffer[fsize] = 0;
+	rewind(file);
+
+	// Copy source into buffer
+	size_t bytes_read = fread(buffer, 1, fsize + 1, file);
+	if (ferror(file) != 0 || bytes_read != fsize || feof(file) == 0) {
+		my_free(buffer);
+		fclose(file);
+		return NULL;
+	}
+
+	fclose(file);
+	return buffer;
+}
+
+// Looks up a shader by file name, e.g. "quad.vert".
+// Returns: null-terminated source, to be freed with my_free(), or NULL on failure.
+char *read_shader_source(const char *name)
+{
+	if (shader_dir) {
+		char path[256];
+		int len = snprintf(path, sizeof(path), "%s/%s", shader_dir, name);
+		if (len < 0 || len >= sizeof(path)) {
+			return NULL;
+		}
+		return read_text_file(path);
+	}
+
+	const ShaderBundleEntry *entry = bsearch(
+		name,
+		shader_bundle,
+		shader_bundle_size,
+		sizeof(ShaderBundleEntry),
+		compare_bundle_entry
+	);
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	// A copy, so that callers free sources the same way wherever they came from
+	char *source = my_malloc(entry->length + 1);
+	if (source) {
+		memcpy(source, shader_bundle_data + entry->offset, entry->length + 1);
+	}
+	return source;
+}
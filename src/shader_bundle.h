@@ -0,0 +1,18 @@
+#ifndef SHADER_BUNDLE_H
+#define SHADER_BUNDLE_H
+
+// Shaders compiled into the executable by tools/embed_shaders.c
+typedef struct ShaderBundleEntry {
+	const char *name; // File name, e.g. "quad.vert"
+	long offset; // Start of the NUL-terminated source in shader_bundle_data
+	long length;
+} ShaderBundleEntry;
+
+extern const char shader_bundle_data[];
+extern const ShaderBundleEntry shader_bundle[]; // Sorted by name
+extern const int shader_bundle_size;
+
+void set_shader_dir(char *dir);
+char *read_shader_source(const char *name);
+
+#endif // SHADER_BUNDLE_H
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "shader_watch.h"
+
+// Reports shader files saved in a directory, for reloading them while running.
+// Editors tend to produce a burst of events per save (and often save by renaming a
+// temporary file into place), so each burst is reduced to one report per name.
+
+#define MAX_PENDING_CHANGES 16
+#define MAX_NAME_LENGTH 64
+
+static int watch_fd = -1;
+static char pending_names[MAX_PENDING_CHANGES][MAX_NAME_LENGTH];
+static int num_pending = 0;
+
+void close_shader_watch(void)
+{
+	if (watch_fd >= 0) {
+		close(watch_fd);
+		watch_fd = -1;
+	}
+}
+
+// Starts watching dir for files being written or moved into it.
+// Returns: success.
+SDL_bool watch_shader_dir(const char *dir)
+{
+	watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch_fd < 0) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(close_shader_watch);
+
+	if (inotify_add_watch(watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		close_shader_watch();
+		return SDL_FALSE;
+	}
+
+	write_log("Watching %s for shader changes\n", dir);
+	return SDL_TRUE;
+}
+
+// Adds a name to the pending list unless it is already there.
+void add_pending_change(const char *name)
+{
+	for (int i = 0; i < num_pending; ++i) {
+		if (strcmp(pending_names[i], name) == 0) {
+			return;
+		}
+	}
+	if (num_pending < MAX_PENDING_CHANGES && strlen(name) < MAX_NAME_LENGTH) {
+		strcpy(pending_names[num_pending++], name);
+	}
+}
+
+// Reads every event waiting on the inotify descriptor, without blocking.
+void read_watch_events(void)
+{
+	// The union aligns the buffer for struct inotify_event
+	union {
+		struct inotify_event event;
+		char bytes[4096];
+	} buf;
+	for (;;) {
+		ssize_t len = read(watch_fd, buf.bytes, sizeof(buf.bytes));
+		if (len <= 0) {
+			if (len < 0 && errno != EAGAIN) {
+				write_log("Stopped watching shaders: read failed\n");
+				close_shader_watch();
+			}
+			return;
+		}
+
+		for (char *ptr = buf.bytes; ptr < buf.bytes + len; ) {
+			struct inotify_event *event = (struct inotify_event *) ptr;
+			if (event->len > 0) {
+				add_pending_change(event->name);
+			}
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
+
+// Call repeatedly until it returns false, e.g. once per frame.
+// Returns: whether name was filled with a file that has changed since last time.
+SDL_bool next_changed_shader(char *name, size_t namesiz)
+{
+	if (watch_fd < 0) {
+		return SDL_FALSE;
+	}
+	if (num_pending == 0) {
+		read_watch_events();
+		if (num_pending == 0) {
+			return SDL_FALSE;
+		}
+	}
+
+	--num_pending;
+	snprintf(name, namesiz, "%s", pending_names[num_pending]);
+	return SDL_TRUE;
+}
@@ -0,0 +1,7 @@
+#ifndef SHADER_WATCH_H
+#define SHADER_WATCH_H
+
+SDL_bool watch_shader_dir(const char *dir);
+SDL_bool next_changed_shader(char *name, size_t namesiz);
+
+#endif // SHADER_WATCH_H
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "glad_gl.h"
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "opengl_util.h"
+#include "snapshot.h"
+
+// Plain-text format, one planet per line after the header:
+// 	planetarium-snapshot 1
+// 	step <step>
+// 	planets <count>
+// 	<x> <y> <dx> <dy> <r> <g> <b> <mass> <radius>
+// Colours are in [0, 1], and mass and radius are relative as for create_planet().
+// Values are written with enough digits that reading them back restores the state
+// exactly.
+
+#define SNAPSHOT_MAGIC "planetarium-snapshot "
+#define SNAPSHOT_VERSION 1
+
+// Makes room for num_planets planets.
+// Returns: success.
+SDL_bool alloc_snapshot(Snapshot *snapshot, int num_planets)
+{
+	*snapshot = (Snapshot) { .num_planets = num_planets };
+	snapshot->motion = my_malloc(sizeof(GLfloat) * 4 * SDL_max(num_planets, 1));
+	snapshot->records = my_malloc(sizeof(GLuint) * 2 * SDL_max(num_planets, 1));
+	if (snapshot->motion == NULL || snapshot->records == NULL) {
+		free_snapshot(snapshot);
+		return SDL_FALSE;
+	}
+	return SDL_TRUE;
+}
+
+void free_snapshot(Snapshot *snapshot)
+{
+	my_free(snapshot->motion);
+	my_free(snapshot->records);
+	*snapshot = (Snapshot) { 0 };
+}
+
+// Returns: success.
+SDL_bool write_snapshot(const char *fname, const Snapshot *snapshot)
+{
+	FILE *file = fopen(fname, "w");
+	if (file == NULL) {
+		return SDL_FALSE;
+	}
+
+	fprintf(file, SNAPSHOT_MAGIC "%d\nstep %" PRIu64 "\nplanets %d\n", SNAPSHOT_VERSION, snapshot->step, snapshot->num_planets);
+	for (int i = 0; i < snapshot->num_planets; ++i) {
+		const GLfloat *motion = &snapshot->motion[4 * i];
+		const GLuint *record = &snapshot->records[2 * i];
+		GLfloat colour[4];
+		unpack_unorm_4x8(record[0], colour);
+		fprintf(
+			file,
+			"%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n",
+			motion[0], motion[1], motion[2], motion[3],
+			colour[0], colour[1], colour[2],
+			half_to_float(record[1] & 0xFFFF),
+			half_to_float(record[1] >> 16)
+		);
+	}
+
+	SDL_bool ok = !ferror(file);
+	return fclose(file) == 0 && ok;
+}
+
+// Loads a file written by write_snapshot() into a snapshot to be freed with
+// free_snapshot().
+// Returns: success.
+SDL_bool read_snapshot(const char *fname, Snapshot *snapshot)
+{
+	FILE *file = fopen(fname, "r");
+	if (file == NULL) {
+		return SDL_FALSE;
+	}
+
+	int version = 0;
+	Uint64 step = 0;
+	int num_planets = 0;
+	if (fscanf(file, SNAPSHOT_MAGIC "%d", &version) != 1
+		|| version != SNAPSHOT_VERSION
+		|| fscanf(file, " step %" SCNu64, &step) != 1
+		|| fscanf(file, " planets %d", &num_planets) != 1
+		|| num_planets < 1
+		|| !alloc_snapshot(snapshot, num_planets)
+	) {
+		write_log("%s is not a snapshot\n", fname);
+		fclose(file);
+		return SDL_FALSE;
+	}
+	snapshot->step = step;
+
+	for (int i = 0; i < num_planets; ++i) {
+		GLfloat *motion = &snapshot->motion[4 * i];
+		GLfloat r, g, b, mass, radius;
+		if (fscanf(file, "%f %f %f %f %f %f %f %f %f", &motion[0], &motion[1], &motion[2], &motion[3], &r, &g, &b, &mass, &radius) != 9) {
+			write_log("%s ends or goes wrong at planet %d of %d\n", fname, i + 1, num_planets);
+			free_snapshot(snapshot);
+			fclose(file);
+			return SDL_FALSE;
+		}
+		// Both are stored as halves and divided by in the shaders. Written this way,
+		// the test also rejects NaN.
+		if (!(mass > 0 && mass <= 65504 && radius > 0 && radius <= 65504)) {
+			write_log("%s has a bad mass or radius at planet %d of %d\n", fname, i + 1, num_planets);
+			free_snapshot(snapshot);
+			fclose(file);
+			return SDL_FALSE;
+		}
+		snapshot->records[2 * i] = pack_unorm_4x8(r, g, b, 1.0);
+		snapshot->records[2 * i + 1] = float_to_half(mass) | (GLuint) float_to_half(radius) << 16;
+	}
+
+	fclose(file);
+	return SDL_TRUE;
+}
@@ -0,0 +1,17 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Planets laid out as in the motion and attribute textures
+typedef struct Snapshot {
+	Uint64 step; // Steps simulated before this state
+	int num_planets;
+	GLfloat *motion; // x, y, dx, dy for each planet
+	GLuint *records; // Packed colour, then packed mass and radius, for each planet
+} Snapshot;
+
+SDL_bool alloc_snapshot(Snapshot *snapshot, int num_planets);
+void free_snapshot(Snapshot *snapshot);
+SDL_bool write_snapshot(const char *fname, const Snapshot *snapshot);
+SDL_bool read_snapshot(const char *fname, Snapshot *snapshot);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,180 @@
+#include <stdio.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "state_exchange.h"
+
+// Hands planet positions from the simulation thread to the render thread through
+// four textures: one being written, the two latest states being drawn between, and
+// the newest finished one waiting to replace them. Neither side ever waits for the
+// other to finish a frame; the only waits are on the GPU, through fences:
+// - written: signalled when a step's copy into the slot is done. The reader makes
+//   its context wait on it before sampling.
+// - read: signalled when the last draw sampling the slot is done. The writer makes
+//   its context wait on it before overwriting.
+// Sync objects are shared between the two contexts, so either may wait on or
+// delete a fence the other created.
+
+#define NUM_SLOTS 4
+
+typedef struct StateSlot {
+	GLuint texture;
+	GLsync written;
+	GLsync read;
+	int num_planets;
+	Uint64 published; // Performance counter value when it was handed over
+	SDL_bool settled; // Drawn as it is rather than interpolated towards
+} StateSlot;
+
+static StateSlot slots[NUM_SLOTS];
+static int back_slot = 0; // Being written by the simulation
+static int ready_slot = 1; // Latest finished state
+static int front_slot = 2; // Being drawn: the latest state taken
+static int previous_slot = 3; // Being drawn: the state taken before it
+static SDL_bool ready_is_new = SDL_FALSE; // Has ready_slot been published since it was last taken?
+static SDL_mutex *exchange_lock = NULL;
+
+// Releases everything acquired by init_state_exchange().
+void destroy_state_exchange(void)
+{
+	for (int i = 0; i < NUM_SLOTS; ++i) {
+		glDeleteSync(slots[i].written);
+		glDeleteSync(slots[i].read);
+		glDeleteTextures(1, &slots[i].texture);
+		slots[i] = (StateSlot) { 0 };
+	}
+	SDL_DestroyMutex(exchange_lock);
+	exchange_lock = NULL;
+}
+
+// Creates the slots, each a width * 1 RGBA32F texture like the motion textures.
+// Call from the render thread's context.
+// Returns: success.
+SDL_bool init_state_exchange(int width)
+{
+	exchange_lock = SDL_CreateMutex();
+	if (exchange_lock == NULL) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(destroy_state_exchange);
+
+	for (int i = 0; i < NUM_SLOTS; ++i) {
+		glGenTextures(1, &slots[i].texture);
+		glBindTexture(GL_TEXTURE_2D, slots[i].texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, 1, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
+	return glGetError() == GL_NO_ERROR;
+}
+
+// Deletes *fence, if there is one, after making the current context's later
+// commands wait for it.
+void wait_for_fence(GLsync *fence)
+{
+	if (*fence) {
+		glWaitSync(*fence, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(*fence);
+		*fence = NULL;
+	}
+}
+
+// Simulation thread: call before writing a new state.
+// Returns: the texture to write it into.
+GLuint state_exchange_begin_write(void)
+{
+	StateSlot *slot = &slots[back_slot];
+	wait_for_fence(&slot->read);
+	// Published but never drawn, so nothing else waits on this
+	glDeleteSync(slot->written);
+	slot->written = NULL;
+	return slot->texture;
+}
+
+// Simulation thread: call once the commands writing the texture from
+// state_exchange_begin_write() have been submitted. Makes it the state the render
+// thread draws next. If settled is set, it's drawn straight away rather than moved
+// into over a step, e.g. for a step taken while paused, whose gap from the one
+// before says nothing about when the next comes.
+void state_exchange_end_write(int num_planets, SDL_bool settled)
+{
+	StateSlot *slot = &slots[back_slot];
+	slot->written = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->num_planets = num_planets;
+	slot->published = SDL_GetPerformanceCounter();
+	slot->settled = settled;
+	// The render context can only see the fence signal once it has been submitted
+	glFlush();
+
+	SDL_LockMutex(exchange_lock);
+		int published = back_slot;
+		back_slot = ready_slot;
+		ready_slot = published;
+		ready_is_new = SDL_TRUE;
+	SDL_UnlockMutex(exchange_lock);
+}
+
+// Returns: whether a state has been published since the render thread last took one.
+SDL_bool state_exchange_has_new(void)
+{
+	SDL_LockMutex(exchange_lock);
+		SDL_bool has_new = ready_is_new;
+	SDL_UnlockMutex(exchange_lock);
+	return has_new;
+}
+
+// Render thread: call before drawing. Picks up the latest state if there is a new
+// one, keeping the one it replaces to draw from. Drawing runs a step behind the
+// simulation, and *state says how far through that step it is, by how long ago the
+// latest state arrived compared to the gap between the two.
+void state_exchange_begin_read(ExchangedState *state)
+{
+	SDL_LockMutex(exchange_lock);
+		if (ready_is_new) {
+			int taken = ready_slot;
+			ready_slot = previous_slot;
+			previous_slot = front_slot;
+			front_slot = taken;
+			ready_is_new = SDL_FALSE;
+		}
+	SDL_UnlockMutex(exchange_lock);
+
+	StateSlot *front = &slots[front_slot];
+	StateSlot *previous = &slots[previous_slot];
+	wait_for_fence(&front->written);
+	wait_for_fence(&previous->written);
+
+	state->current = front->num_planets > 0 ? front->texture : 0;
+	state->previous = previous->texture;
+	state->num_planets = front->num_planets;
+	state->num_previous_planets = previous->num_planets;
+	state->interpolation = 1.0;
+	if (!front->settled && previous->num_planets > 0 && front->published > previous->published) {
+		double since = SDL_GetPerformanceCounter() - front->published;
+		state->interpolation = SDL_min(1.0, since / (front->published - previous->published));
+	}
+}
+
+// Marks slot as drawn from by everything submitted so far.
+void fence_read(StateSlot *slot)
+{
+	// A later fence covers every earlier draw, so only the newest is kept
+	glDeleteSync(slot->read);
+	slot->read = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Render thread: call once the commands reading the textures from
+// state_exchange_begin_read() have been submitted.
+void state_exchange_end_read(void)
+{
+	fence_read(&slots[front_slot]);
+	fence_read(&slots[previous_slot]);
+	glFlush();
+}
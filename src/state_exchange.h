@@ -0,0 +1,21 @@
+#ifndef STATE_EXCHANGE_H
+#define STATE_EXCHANGE_H
+
+// What the render thread draws: the two latest published states and how far
+// between them to place each planet
+typedef struct ExchangedState {
+	GLuint current; // 0 if nothing has been published yet
+	GLuint previous;
+	int num_planets;
+	int num_previous_planets; // Planets added since are only in current
+	GLfloat interpolation; // 0 draws previous, 1 draws current
+} ExchangedState;
+
+SDL_bool init_state_exchange(int width);
+GLuint state_exchange_begin_write(void);
+void state_exchange_end_write(int num_planets, SDL_bool settled);
+SDL_bool state_exchange_has_new(void);
+void state_exchange_begin_read(ExchangedState *state);
+void state_exchange_end_read(void);
+
+#endif // STATE_EXCHANGE_H
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <inttypes.h>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2.h>
+#else
+#include "glad_gl.h"
+#endif
+
+#include <SDL2/SDL.h>
+
+#include "util.h"
+#include "trace.h"
+
+// Frame timeline of CPU zones and GPU passes, written out in the Chrome trace event
+// format (load it in chrome://tracing or ui.perfetto.dev). Events go into a fixed
+// ring big enough for the last few frames, so recording costs a counter read and a
+// store, and nothing at all when tracing is off.
+
+#define TRACE_EVENTS_PER_FRAME 16 // Comfortably above the zones and passes in a frame
+#define TRACE_SLACK_FRAMES 8 // GPU passes are recorded a few frames after the CPU zones
+#define TRACE_RESYNC_FRAMES 600 // How often to re-measure the CPU-GPU clock offset
+
+// Timeline rows in the trace viewer
+#define TRACE_TID_CPU 1
+#define TRACE_TID_GPU 2
+
+typedef struct TraceEvent {
+	const char *name;
+	int tid;
+	Uint64 frame;
+	double start_us;
+	double duration_us;
+} TraceEvent;
+
+static const char *trace_zone_names[NUM_TRACE_ZONES] = {
+	[TRACE_FRAME] = "frame",
+	[TRACE_UPDATE] = "update",
+	[TRACE_GPU_UPDATE] = "gpu_update",
+	[TRACE_DRAW] = "draw",
+	[TRACE_SWAP] = "swap",
+	[TRACE_SLEEP] = "sleep",
+	[TRACE_GPU_WAIT] = "gpu_wait",
+};
+
+static SDL_bool trace_enabled = SDL_FALSE;
+static char *trace_fname = NULL;
+static int trace_num_frames = 0; // How many frames write_trace() covers
+static TraceEvent *trace_events = NULL; // Ring buffer
+static int trace_capacity = 0;
+static int trace_next = 0;
+static int trace_count = 0;
+static Uint64 trace_frame = 0;
+static Uint64 trace_epoch; // Performance counter at init_trace()
+static Uint64 trace_zone_starts[NUM_TRACE_ZONES];
+static double trace_gpu_offset_us = 0.0; // Add to GPU time to get trace time
+
+// Returns: performance counter value converted to microseconds since init_trace().
+double trace_counter_to_us(Uint64 counter)
+{
+	return (double) (counter - trace_epoch) * 1e6 / SDL_GetPerformanceFrequency();
+}
+
+// Frees the event ring.
+void free_trace(void)
+{
+	my_free(trace_events);
+	trace_events = NULL;
+	trace_enabled = SDL_FALSE;
+}
+
+// Starts recording. Until this is called, the other functions do nothing.
+// Returns: success.
+SDL_bool init_trace(char *fname, int num_frames)
+{
+	trace_capacity = (num_frames + TRACE_SLACK_FRAMES) * TRACE_EVENTS_PER_FRAME;
+	trace_events = my_malloc(trace_capacity * sizeof(TraceEvent));
+	if (trace_events == NULL) {
+		return SDL_FALSE;
+	}
+	push_cleanup_fn(free_trace);
+
+	trace_fname = fname;
+	trace_num_frames = num_frames;
+	trace_epoch = SDL_GetPerformanceCounter();
+	trace_enabled = SDL_TRUE;
+	trace_sync_gpu_clock();
+	return SDL_TRUE;
+}
+
+// Pairs the current GPU and CPU clocks, so GPU timestamps can go on the same timeline.
+void trace_sync_gpu_clock(void)
+{
+#ifndef __EMSCRIPTEN__
+	if (!trace_enabled) {
+		return;
+	}
+	GLint64 gpu_now;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+	Uint64 cpu_now = SDL_GetPerformanceCounter();
+	trace_gpu_offset_us = trace_counter_to_us(cpu_now) - gpu_now / 1000.0;
+#endif
+}
+
+// Call once at the start of every frame.
+void trace_begin_frame(void)
+{
+	if (!trace_enabled) {
+		return;
+	}
+	++trace_frame;
+	if (trace_frame % TRACE_RESYNC_FRAMES == 0) {
+		trace_sync_gpu_clock();
+	}
+}
+
+// Returns: the frame being traced, for tagging GPU work that is read back later.
+Uint64 trace_frame_number(void)
+{
+	return trace_frame;
+}
+
+void push_trace_event(const char *name, int tid, Uint64 frame, double start_us, double duration_us)
+{
+	TraceEvent *event = &trace_events[trace_next];
+	event->name = name;
+	event->tid = tid;
+	event->frame = frame;
+	event->start_us = start_us;
+	event->duration_us = duration_us;
+	trace_next = (trace_next + 1) % trace_capacity;
+	trace_count = SDL_min(trace_count + 1, trace_capacity);
+}
+
+// Marks the start of a CPU zone. Zones of different kinds may nest.
+void trace_begin(TraceZone zone)
+{
+	if (trace_enabled) {
+		trace_zone_starts[zone] = SDL_GetPerformanceCounter();
+	}
+}
+
+// Marks the end of a zone started with trace_begin().
+void trace_end(TraceZone zone)
+{
+	if (!trace_enabled) {
+		return;
+	}
+	double start_us = trace_counter_to_us(trace_zone_starts[zone]);
+	double end_us = trace_counter_to_us(SDL_GetPerformanceCounter());
+	push_trace_event(trace_zone_names[zone], TRACE_TID_CPU, trace_frame, start_us, end_us - start_us);
+}
+
+// Adds a GPU pass measured with GL_TIMESTAMP queries during the given frame.
+void trace_gpu_zone(const char *name, Uint64 frame, GLuint64 start_ns, GLuint64 end_ns)
+{
+	if (!trace_enabled) {
+		return;
+	}
+	double start_us = start_ns / 1000.0 + trace_gpu_offset_us;
+	double duration_us = end_ns > start_ns ? (end_ns - start_ns) / 1000.0 : 0.0;
+	push_trace_event(name, TRACE_TID_GPU, frame, start_us, duration_us);
+}
+
+// Writes the last trace_num_frames frames to the file given to init_trace().
+// Returns: success.
+SDL_bool write_trace(void)
+{
+	if (!trace_enabled) {
+		return SDL_FALSE;
+	}
+
+	FILE *file = fopen(trace_fname, "w");
+	if (file == NULL) {
+		write_log("Failed to open trace file %s\n", trace_fname);
+		return SDL_FALSE;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU\"}},\n", TRACE_TID_CPU);
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", TRACE_TID_GPU);
+
+	Uint64 first_frame = trace_frame >= trace_num_frames ? trace_frame - trace_num_frames + 1 : 0;
+	int written = 0;
+	for (int i = 0; i < trace_count; ++i) {
+		TraceEvent *event = &trace_events[(trace_next - trace_count + i + trace_capacity) % trace_capacity];
+		if (event->frame < first_frame) {
+			continue;
+		}
+		fprintf(
+			file,
+			",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%" PRIu64 "}}",
+			event->name,
+			event->tid,
+			event->start_us,
+			event->duration_us,
+			event->frame
+		);
+		++written;
+	}
+
+	fprintf(file, "\n]}\n");
+	if (fclose(file) != 0) {
+		write_log("Failed to close trace file %s\n", trace_fname);
+		return SDL_FALSE;
+	}
+	write_log("Wrote %d trace events to %s\n", written, trace_fname);
+	return SDL_TRUE;
+}
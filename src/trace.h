@@ -0,0 +1,25 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// CPU zones recorded with trace_begin() / trace_end(). Keep in step with trace_zone_names.
+typedef enum TraceZone {
+	TRACE_FRAME,
+	TRACE_UPDATE,
+	TRACE_GPU_UPDATE,
+	TRACE_DRAW,
+	TRACE_SWAP,
+	TRACE_SLEEP,
+	TRACE_GPU_WAIT,
+	NUM_TRACE_ZONES,
+} TraceZone;
+
+SDL_bool init_trace(char *fname, int num_frames);
+void trace_sync_gpu_clock(void);
+void trace_begin_frame(void);
+Uint64 trace_frame_number(void);
+void trace_begin(TraceZone zone);
+void trace_end(TraceZone zone);
+void trace_gpu_zone(const char *name, Uint64 frame, GLuint64 start_ns, GLuint64 end_ns);
+SDL_bool write_trace(void);
+
+#endif // TRACE_H
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Build-time tool: writes a C file holding every shader given on the command line,
+// for shader_bundle.c to look up by file name. Sources are stored once each, NUL
+// terminated, in one string; files with identical contents share storage.
+// Usage: embed_shaders OUTPUT.c SHADER...
+
+typedef struct Shader {
+	const char *name; // File name without directories
+	char *source;
+	long length;
+	long offset; // Into the bundle string
+} Shader;
+
+// Returns: contents of a file, NUL terminated, or NULL on failure.
+char *read_file(const char *path, long *length)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	char *buffer = NULL;
+	if (fseek(file, 0, SEEK_END) == 0 && (*length = ftell(file)) >= 0) {
+		rewind(file);
+		buffer = malloc(*length + 1);
+		if (buffer && fread(buffer, 1, *length, file) == *length) {
+			buffer[*length] = 0;
+		} else {
+			free(buffer);
+			buffer = NULL;
+		}
+	}
+	fclose(file);
+	return buffer;
+}
+
+int compare_names(const void *a, const void *b)
+{
+	return strcmp(((const Shader *) a)->name, ((const Shader *) b)->name);
+}
+
+// Writes source as a run of string literals, one per line of source.
+void write_literal(FILE *out, const char *source, long length)
+{
+	fputs("\t\"", out);
+	for (long i = 0; i < length; ++i) {
+		unsigned char c = source[i];
+		if (c == '\n') {
+			fputs(i + 1 < length ? "\\n\"\n\t\"" : "\\n", out);
+		} else if (c == '\\' || c == '"') {
+			fprintf(out, "\\%c", c);
+		} else if (c == '\t') {
+			fputs("\\t", out);
+		} else if (c < ' ' || c > '~') {
+			// Always three digits, so a following digit can't extend the escape
+			fprintf(out, "\\%03o", c);
+		} else {
+			fputc(c, out);
+		}
+	}
+	fputs("\\0\"\n", out);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s OUTPUT.c SHADER...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int num_shaders = argc - 2;
+	Shader *shaders = calloc(num_shaders > 0 ? num_shaders : 1, sizeof(Shader));
+	for (int i = 0; i < num_shaders; ++i) {
+		const char *path = argv[i + 2];
+		const char *slash = strrchr(path, '/');
+		shaders[i].name = slash ? slash + 1 : path;
+		shaders[i].source = read_file(path, &shaders[i].length);
+		if (shaders[i].source == NULL || strlen(shaders[i].source) != shaders[i].length) {
+			fprintf(stderr, "%s: can't read %s, or it contains NUL bytes\n", argv[0], path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Sorted so that lookups can binary search
+	qsort(shaders, num_shaders, sizeof(Shader), compare_names);
+	for (int i = 1; i < num_shaders; ++i) {
+		if (strcmp(shaders[i - 1].name, shaders[i].name) == 0) {
+			fprintf(stderr, "%s: %s given twice\n", argv[0], shaders[i].name);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *out = fopen(argv[1], "w");
+	if (out == NULL) {
+		fprintf(stderr, "%s: can't open %s\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(out, "// Generated by tools/embed_shaders.c. Do not edit.\n\n");
+	fprintf(out, "#include \"shader_bundle.h\"\n\n");
+	fprintf(out, "const char shader_bundle_data[] =\n");
+	long offset = 0;
+	for (int i = 0; i < num_shaders; ++i) {
+		shaders[i].offset = -1;
+		for (int j = 0; j < i; ++j) {
+			if (shaders[j].length == shaders[i].length && strcmp(shaders[j].source, shaders[i].source) == 0) {
+				shaders[i].offset = shaders[j].offset;
+				break;
+			}
+		}
+		if (shaders[i].offset < 0) {
+			fprintf(out, "\t// %s\n", shaders[i].name);
+			write_literal(out, shaders[i].source, shaders[i].length);
+			shaders[i].offset = offset;
+			offset += shaders[i].length + 1;
+		}
+	}
+	fprintf(out, "\t\"\";\n\n");
+
+	fprintf(out, "const ShaderBundleEntry shader_bundle[] = {\n");
+	for (int i = 0; i < num_shaders; ++i) {
+		fprintf(out, "\t{ \"%s\", %ld, %ld },\n", shaders[i].name, shaders[i].offset, shaders[i].length);
+	}
+	fprintf(out, "};\n\n");
+	fprintf(out, "const int shader_bundle_size = %d;\n", num_shaders);
+
+	if (fclose(out) != 0) {
+		fprintf(stderr, "%s: failed to write %s\n", argv[0], argv[1]);
+		remove(argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}